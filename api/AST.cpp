@@ -1,128 +1,304 @@
 #include "AST.hpp"
+#include "ASTVisitor.hpp"
 
-#include <stack>
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <thread>
 
 namespace ozToy::AST {
 
-	void Module::addTopLevel(TopLevel* topLevel)
-	{
-		this->topLevel.push_back(topLevel);
-	}
+	namespace {
+		// Stamps the source offset on a freshly built AST node or HIR value.
+		template <typename T>
+		T* withOffset(T* node, std::uint32_t offset)
+		{
+			node->setOffset(offset);
+			return node;
+		}
 
-	void Module::generateHIR(HIR::ModuleBuilder& mBuilder)
-	{
-		auto&& m = *new HIR::ModuleBuilder(mBuilder.getModule().createModule(this->name));
-		for (auto& topLevel : this->topLevel)
+		// Consumes "module name {" into keyword and name, or reports the first mismatch.
+		bool parseModuleHeader(Scanner* scanner, Token& keyword, Token& name, std::ostream& errorOut)
 		{
-			topLevel->generateHIR(m);
+			keyword = scanner->getToken();
+			name = scanner->getToken();
+			if (name.type != TokenType::IDENTIFIER)
+			{
+				errorOut << scanner->getLocation(name) << ": Expected module name, got " << name.toString() << std::endl;
+				return false;
+			}
+			auto leftBrace = scanner->getToken();
+			
+			if (leftBrace.type != TokenType::LEFT_BRACE)
+			{
+				errorOut << scanner->getLocation(leftBrace) << ": Expected {, got " << leftBrace.toString() << std::endl;
+				return false;
+			}
+			return true;
 		}
-		delete &m;
-	}
 
-	Module::~Module()
-	{
-		for (auto& topLevel : this->topLevel)
+		// An item's tokens [begin, end), found by Root::parseParallel's pre-pass
+		struct ItemBounds
+		{
+			enum class Kind { FUNCTION, MODULE_BEGIN, MODULE_END } kind;
+			std::size_t begin;
+			std::size_t end;
+		};
+
+		// Splits the stream into items by brace matching; false leaves it to the serial parser
+		bool findItems(const TokenStream& stream, std::vector<ItemBounds>& items)
 		{
-			delete topLevel;
+			std::size_t index = 0;
+			std::size_t moduleDepth = 0;
+			while (true)
+			{
+				switch (stream.getType(index))
+				{
+				case TokenType::END_OF_FILE:
+					return moduleDepth == 0;
+				case TokenType::RIGHT_BRACE:
+					if (moduleDepth == 0)
+						return false;
+					--moduleDepth;
+					items.push_back({ ItemBounds::Kind::MODULE_END, index, index + 1 });
+					++index;
+					break;
+				case TokenType::MODULE:
+					if (stream.getType(index + 1) != TokenType::IDENTIFIER || stream.getType(index + 2) != TokenType::LEFT_BRACE)
+						return false;
+					++moduleDepth;
+					items.push_back({ ItemBounds::Kind::MODULE_BEGIN, index, index + 3 });
+					index += 3;
+					break;
+				case TokenType::FN:
+				{
+					std::size_t begin = index++;
+					// The signature has no braces, so the body starts at the first one
+					while (stream.getType(index) != TokenType::LEFT_BRACE)
+					{
+						TokenType type = stream.getType(index);
+						if (type == TokenType::END_OF_FILE || type == TokenType::RIGHT_BRACE || type == TokenType::FN || type == TokenType::MODULE)
+							return false;
+						++index;
+					}
+					std::size_t depth = 0;
+					do {
+						TokenType type = stream.getType(index++);
+						if (type == TokenType::LEFT_BRACE)
+							++depth;
+						else if (type == TokenType::RIGHT_BRACE)
+							--depth;
+						else if (type == TokenType::END_OF_FILE)
+							return false;
+					} while (depth != 0);
+					items.push_back({ ItemBounds::Kind::FUNCTION, begin, index });
+					break;
+				}
+				default:
+					return false;
+				}
+			}
 		}
 	}
 
-	Module* Module::parse(Scanner* scanner, std::ostream& errorOut)
+	void Module::setTopLevel(ArenaSpan<TopLevel*> topLevel)
 	{
-		scanner->consumeToken(); // Consume the module keyword
-		auto name = scanner->getToken();
-		if (name.type != TokenType::IDENTIFIER)
+		this->topLevel = topLevel;
+	}
+
+	Hash128 Module::getHash() const
+	{
+		if (!this->hashed)
 		{
-			errorOut << "Expected module name, got " << name.toString() << std::endl;
-			return nullptr;
+			this->hash = hashModule(this);
+			this->hashed = true;
 		}
-		auto module = new Module(name.text);
-		auto leftBrace = scanner->getToken();
-		
-		if (leftBrace.type != TokenType::LEFT_BRACE)
-		{
-			errorOut << "Expected {, got " << leftBrace.toString() << std::endl;
-			delete module;
+		return this->hash;
+	}
+
+	Module* Module::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut, BodyParsing bodies)
+	{
+		Token keyword;
+		Token name;
+		if (!parseModuleHeader(scanner, keyword, name, errorOut))
 			return nullptr;
-		}
+		auto module = withOffset(arena.create<Module>(arena.copy(name.text)), keyword.offset);
 		
+		std::vector<TopLevel*> topLevel;
 		while (true)
 		{
 			if (scanner->peekToken().type == TokenType::RIGHT_BRACE)
 				break;
-			auto topLevel = TopLevel::parse(scanner, errorOut);
-			if (topLevel == nullptr)
-			{
-				delete module;
+			auto item = TopLevel::parse(scanner, arena, errorOut, bodies);
+			if (item == nullptr)
 				return nullptr;
-			}
-			module->addTopLevel(topLevel);
+			topLevel.push_back(item);
 		}
+		scanner->consumeToken(); // Consume the }
+		module->setTopLevel(arena.copy(topLevel));
+		// Lazy bodies are left alone until someone asks for the hash, and so is a piped parse
+		if (bodies == BodyParsing::EAGER && !scanner->isPiped())
+			module->getHash();
 		return module;
 	}
 
-	Root::Root() {}
+	Root::Root() : Node(NodeKind::ROOT) {}
+
+	Root::~Root()
+	{
+		for (auto workerArena : this->workerArenas)
+			delete workerArena;
+	}
 
 	void Root::addTopLevel(TopLevel* topLevel)
 	{
 		this->topLevel.push_back(topLevel);
 	}
 
-	void Root::generateHIR(HIR::ModuleBuilder& mBuilder)
+	Root* Root::parse(Scanner* scanner, std::ostream& errorOut, BodyParsing bodies)
 	{
-		for (auto& topLevel : this->topLevel)
+		auto root = new Root();
+		while (true)
 		{
-			topLevel->generateHIR(mBuilder);
+			if (scanner->peekToken().type == TokenType::END_OF_FILE)
+				break;
+			auto topLevel = TopLevel::parse(scanner, root->arena, errorOut, bodies);
+			if (topLevel == nullptr)
+			{
+				delete root;
+				return nullptr;
+			}
+			root->addTopLevel(topLevel);
 		}
+		return root;
 	}
 
-	Root::~Root()
+	Root* Root::parseParallel(TokenStream* stream, std::size_t threadCount, std::ostream& errorOut)
 	{
-		for (auto& topLevel : this->topLevel)
+		std::vector<ItemBounds> items;
+		if (!findItems(*stream, items))
 		{
-			delete topLevel;
+			Scanner scanner(stream);
+			return parse(&scanner, errorOut);
 		}
-	}
 
-	Root* Root::parse(Scanner* scanner, std::ostream& errorOut)
-	{
+		std::vector<std::size_t> functions;
+		for (std::size_t i = 0; i < items.size(); ++i)
+		{
+			if (items[i].kind == ItemBounds::Kind::FUNCTION)
+				functions.push_back(i);
+		}
+
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		threadCount = std::max<std::size_t>(1, std::min(threadCount, functions.size()));
+
 		auto root = new Root();
-		while (true)
+		std::vector<TopLevel*> parsed(functions.size(), nullptr);
+		// What each failed function printed; a wrong split falls back to the serial parser
+		std::vector<std::string> diagnostics(functions.size());
+		std::atomic<std::size_t> nextJob(0);
+		// Skipped after the first failure
+		std::atomic<std::size_t> firstFailure(functions.size());
+
+		auto work = [&](Arena& arena) {
+			Scanner scanner(stream);
+			std::ostringstream errors;
+			while (true)
+			{
+				std::size_t job = nextJob.fetch_add(1, std::memory_order_relaxed);
+				if (job >= functions.size() || job > firstFailure.load(std::memory_order_relaxed))
+					break;
+				const ItemBounds& bounds = items[functions[job]];
+				scanner.rewind(bounds.begin);
+				parsed[job] = DeclarationFunction::parse(&scanner, arena, errors);
+				if (parsed[job] == nullptr || scanner.mark() != bounds.end)
+				{
+					diagnostics[job] = errors.str();
+					errors.str(std::string());
+					std::size_t failure = firstFailure.load(std::memory_order_relaxed);
+					while (job < failure && !firstFailure.compare_exchange_weak(failure, job, std::memory_order_relaxed))
+						;
+				}
+			}
+		};
+
+		root->workerArenas.resize(threadCount);
+		for (auto& workerArena : root->workerArenas)
+			workerArena = new Arena();
+		std::vector<std::thread> workers;
+		for (std::size_t i = 1; i < threadCount; ++i)
+			workers.emplace_back(work, std::ref(*root->workerArenas[i]));
+		work(*root->workerArenas[0]);
+		for (auto& worker : workers)
+			worker.join();
+
+		std::size_t failure = firstFailure.load();
+		if (failure != functions.size())
 		{
-			if (scanner->peekToken().type == TokenType::END_OF_FILE)
+			delete root;
+			if (parsed[failure] != nullptr)
+			{
+				Scanner scanner(stream);
+				return parse(&scanner, errorOut);
+			}
+			errorOut << diagnostics[failure];
+			return nullptr;
+		}
+
+		// Modules still open, innermost last, and the items collected for each
+		std::vector<Module*> modules;
+		std::vector<std::vector<TopLevel*>> levels(1);
+		std::size_t job = 0;
+		for (const ItemBounds& bounds : items)
+		{
+			switch (bounds.kind)
+			{
+			case ItemBounds::Kind::FUNCTION:
+				levels.back().push_back(parsed[job++]);
 				break;
-			auto topLevel = TopLevel::parse(scanner, errorOut);
-			if (topLevel == nullptr)
+			case ItemBounds::Kind::MODULE_BEGIN:
+				modules.push_back(withOffset(root->arena.create<Module>(root->arena.copy(stream->get(bounds.begin + 1).text)), stream->getOffset(bounds.begin)));
+				levels.emplace_back();
+				break;
+			case ItemBounds::Kind::MODULE_END:
 			{
-				delete root;
-				return nullptr;
+				Module* module = modules.back();
+				modules.pop_back();
+				module->setTopLevel(root->arena.copy(levels.back()));
+				module->getHash();
+				levels.pop_back();
+				levels.back().push_back(module);
+				break;
+			}
 			}
-			root->addTopLevel(topLevel);
 		}
+		for (auto topLevel : levels.back())
+			root->addTopLevel(topLevel);
 		return root;
 	}
 
-	TopLevel* TopLevel::parse(Scanner* scanner, std::ostream& errorOut)
+	TopLevel* TopLevel::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut, BodyParsing bodies)
 	{
 		Token token = scanner->peekToken();
 		switch (token.type)
 		{
 		case TokenType::MODULE:
-			return Module::parse(scanner, errorOut);
+			return Module::parse(scanner, arena, errorOut, bodies);
 		case TokenType::FN:
-			return DeclarationFunction::parse(scanner, errorOut);
+			return DeclarationFunction::parse(scanner, arena, errorOut, bodies);
 		default:
-			errorOut << "Expected top level declaration, got " << token.toString() << std::endl;
+			errorOut << scanner->getLocation(token) << ": Expected top level declaration, got " << token.toString() << std::endl;
 			return nullptr;
 		}
 	}
 
-	void DeclarationFunction::addArgument(Argument* argument)
+	void DeclarationFunction::setArguments(ArenaSpan<Argument*> arguments)
 	{
-		this->arguments.push_back(argument);
+		this->arguments = arguments;
 	}
 
-	void DeclarationFunction::setReturnType(std::string returnType)
+	void DeclarationFunction::setReturnType(std::string_view returnType)
 	{
 		this->returnType = returnType;
 	}
@@ -132,160 +308,187 @@ namespace ozToy::AST {
 		this->body = body;
 	}
 
-	void DeclarationFunction::generateHIR(HIR::ModuleBuilder& mBuilder)
+	bool DeclarationFunction::parseBody(std::ostream& errorOut) const
 	{
-		auto&& fBuilder = *new HIR::FunctionBuilder(mBuilder.getModule().createFunction(this->name));
-
-		for (auto& argument : this->arguments)
-		{
-			fBuilder.addArgument(argument->getName(), argument->getType());
-		}
+		if (this->lazyBody == nullptr)
+			return this->body != nullptr;
 
-		this->body->generateHIR(fBuilder);
-
-		delete &fBuilder;
+		Scanner scanner(this->lazyBody->stream);
+		scanner.rewind(this->lazyBody->begin);
+		this->body = BlockExpression::parse(&scanner, *this->lazyBody->arena, errorOut);
+		this->lazyBody = nullptr;
+		this->hash = hashFunction(this, scanner.getSymbols());
+		return this->body != nullptr;
 	}
 
-	DeclarationFunction::~DeclarationFunction()
+	Hash128 DeclarationFunction::getHash() const
 	{
-		for (auto& argument : this->arguments)
+		parseBody();
+		if (this->unhashedSymbols != nullptr)
 		{
-			delete argument;
+			this->hash = hashFunction(this, this->unhashedSymbols);
+			this->unhashedSymbols = nullptr;
 		}
-		delete this->body;
+		return this->hash;
 	}
 
-	DeclarationFunction* DeclarationFunction::parse(Scanner* scanner, std::ostream& errorOut)
+	DeclarationFunction* DeclarationFunction::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut, BodyParsing bodies)
 	{
-		scanner->consumeToken(); // Consume the fn keyword
+		auto keyword = scanner->getToken();
 		auto name = scanner->getToken();
 		if (name.type != TokenType::IDENTIFIER)
 		{
-			errorOut << "Expected function name, got " << name.toString() << std::endl;
+			errorOut << scanner->getLocation(name) << ": Expected function name, got " << name.toString() << std::endl;
 			return nullptr;
 		}
 
-		auto function = new DeclarationFunction(name.text);
+		auto function = withOffset(arena.create<DeclarationFunction>(arena.copy(name.text)), keyword.offset);
 
-		if (scanner->getToken().type != TokenType::LEFT_PAREN)
+		auto leftParen = scanner->getToken();
+		if (leftParen.type != TokenType::LEFT_PAREN)
 		{
-			errorOut << "Expected (, got " << name.toString() << std::endl;
-			delete function;
+			errorOut << scanner->getLocation(leftParen) << ": Expected (, got " << leftParen.toString() << std::endl;
 			return nullptr;
 		}
 
 		if (scanner->peekToken().type != TokenType::RIGHT_PAREN)
 		{
+			std::vector<Argument*> arguments;
 			while (true)
 			{
-				auto argument = Argument::parse(scanner, errorOut);
+				auto argument = Argument::parse(scanner, arena, errorOut);
 				if (argument == nullptr)
-				{
-					delete function;
 					return nullptr;
-				}
-				function->addArgument(argument);
+				arguments.push_back(argument);
 				if (scanner->peekToken().type == TokenType::RIGHT_PAREN)
 					break;
-				if (scanner->getToken().type != TokenType::COMMA)
+				auto comma = scanner->getToken();
+				if (comma.type != TokenType::COMMA)
 				{
-					errorOut << "Expected , or ), got " << scanner->getToken().toString() << std::endl;
-					delete function;
+					errorOut << scanner->getLocation(comma) << ": Expected , or ), got " << comma.toString() << std::endl;
 					return nullptr;
 				}
 			}
+			function->setArguments(arena.copy(arguments));
 		}
 
 		scanner->consumeToken(); // Consume the )
 
-		if (scanner->getToken().type != TokenType::ARROW)
+		auto arrow = scanner->getToken();
+		if (arrow.type != TokenType::ARROW)
 		{
-			errorOut << "Expected ->, got " << scanner->getToken().toString() << std::endl;
-			delete function;
+			errorOut << scanner->getLocation(arrow) << ": Expected ->, got " << arrow.toString() << std::endl;
 			return nullptr;
 		}
 
 		auto returnType = scanner->getToken();
 		if (returnType.type != TokenType::IDENTIFIER)
 		{
-			errorOut << "Expected return type, got " << returnType.toString() << std::endl;
-			delete function;
+			errorOut << scanner->getLocation(returnType) << ": Expected return type, got " << returnType.toString() << std::endl;
 			return nullptr;
 		}
 
-		function->setReturnType(returnType.text);
+		function->setReturnType(arena.copy(returnType.text));
 
-		if (scanner->peekToken().type != TokenType::LEFT_BRACE)
+		auto leftBrace = scanner->peekToken();
+		if (leftBrace.type != TokenType::LEFT_BRACE)
 		{
-			errorOut << "Expected {, got " << scanner->getToken().toString() << std::endl;
-			delete function;
+			errorOut << scanner->getLocation(leftBrace) << ": Expected {, got " << leftBrace.toString() << std::endl;
 			return nullptr;
 		}
 
-		auto body = BlockExpression::parse(scanner, errorOut);
+		TokenStream* stream = scanner->getStream();
+		if (bodies == BodyParsing::LAZY && stream != nullptr)
+		{
+			std::size_t begin = scanner->mark();
+			std::size_t index = begin;
+			std::size_t depth = 0;
+			do {
+				TokenType type = stream->getType(index++);
+				if (type == TokenType::LEFT_BRACE)
+					++depth;
+				else if (type == TokenType::RIGHT_BRACE)
+					--depth;
+				else if (type == TokenType::END_OF_FILE)
+				{
+					Token end = stream->get(index - 1);
+					errorOut << scanner->getLocation(end) << ": Expected }, got " << end.toString() << std::endl;
+					return nullptr;
+				}
+			} while (depth != 0);
+			scanner->rewind(index);
+			function->lazyBody = arena.create<LazyBody>(LazyBody{ stream, &arena, begin });
+			return function;
+		}
+
+		auto body = BlockExpression::parse(scanner, arena, errorOut);
 
 		if (body == nullptr)
-		{
-			delete function;
 			return nullptr;
-		}
 
 		function->setBody(body);
+		// A pipe's producer is still interning, so hashing waits for getHash()
+		if (scanner->isPiped())
+			function->unhashedSymbols = scanner->getSymbols();
+		else
+			function->hash = hashFunction(function, scanner->getSymbols());
 
 		return function;
 	}
 
-	Argument* Argument::parse(Scanner* scanner, std::ostream& errorOut)
+	Argument* Argument::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut)
 	{
 		auto name = scanner->getToken();
 		if (name.type != TokenType::IDENTIFIER)
 		{
-			errorOut << "Expected argument name, got " << name.toString() << std::endl;
+			errorOut << scanner->getLocation(name) << ": Expected argument name, got " << name.toString() << std::endl;
 			return nullptr;
 		}
 
-		if (scanner->getToken().type != TokenType::COLON)
+		auto colon = scanner->getToken();
+		if (colon.type != TokenType::COLON)
 		{
-			errorOut << "Expected :, got " << scanner->getToken().toString() << std::endl;
+			errorOut << scanner->getLocation(colon) << ": Expected :, got " << colon.toString() << std::endl;
 			return nullptr;
 		}
 
 		auto type = scanner->getToken();
 		if (type.type != TokenType::IDENTIFIER)
 		{
-			errorOut << "Expected argument type, got " << type.toString() << std::endl;
+			errorOut << scanner->getLocation(type) << ": Expected argument type, got " << type.toString() << std::endl;
 			return nullptr;
 		}
 
-		return new Argument(name.text, type.text);
+		return withOffset(arena.create<Argument>(arena.copy(name.text), arena.copy(type.text)), name.offset);
 	}
 
-	Expression* Expression::parsePrimary(Scanner* scanner, std::ostream& errorOut)
+	Expression* Expression::parsePrimary(Scanner* scanner, Arena& arena, std::ostream& errorOut)
 	{
 		Token token = scanner->peekToken();
 		switch (token.type) {
 		case TokenType::IDENTIFIER:
 			scanner->consumeToken();
-			return new IdentifierExpression(token.text);
+			return withOffset(arena.create<IdentifierExpression>(token.symbol), token.offset);
 		case TokenType::NUMBER:
+		case TokenType::FLOAT:
 			scanner->consumeToken();
-			return new NumberExpression(token.text);
+			return withOffset(arena.create<NumberExpression>(token.number, token.type == TokenType::FLOAT), token.offset);
 		case TokenType::STRING:
 			scanner->consumeToken();
-			return new StringExpression(token.text);
+			return withOffset(arena.create<StringExpression>(arena.copy(decodeEscapes(token.text))), token.offset);
 		case TokenType::CHAR:
 			scanner->consumeToken();
-			return new CharExpression(token.text);
+			return withOffset(arena.create<CharExpression>(arena.copy(decodeEscapes(token.text))), token.offset);
 		case TokenType::LEFT_PAREN:
 			scanner->consumeToken();
 			{
-				auto expression = parse(scanner, errorOut);
+				auto expression = parse(scanner, arena, errorOut);
 				if (expression == nullptr)
 					return nullptr;
-				if (scanner->getToken().type != TokenType::RIGHT_PAREN)
+				auto rightParen = scanner->getToken();
+				if (rightParen.type != TokenType::RIGHT_PAREN)
 				{
-					errorOut << "Expected ), got " << scanner->getToken().toString() << std::endl;
-					delete expression;
+					errorOut << scanner->getLocation(rightParen) << ": Expected ), got " << rightParen.toString() << std::endl;
 					return nullptr;
 				}
 				return expression;
@@ -293,13 +496,13 @@ namespace ozToy::AST {
 		case TokenType::LEFT_BRACE:
 			scanner->consumeToken();
 			{
-				auto expression = parse(scanner, errorOut);
+				auto expression = parse(scanner, arena, errorOut);
 				if (expression == nullptr)
 					return nullptr;
-				if (scanner->getToken().type != TokenType::RIGHT_BRACE)
+				auto rightBrace = scanner->getToken();
+				if (rightBrace.type != TokenType::RIGHT_BRACE)
 				{
-					errorOut << "Expected }, got " << scanner->getToken().toString() << std::endl;
-					delete expression;
+					errorOut << scanner->getLocation(rightBrace) << ": Expected }, got " << rightBrace.toString() << std::endl;
 					return nullptr;
 				}
 				return expression;
@@ -307,121 +510,161 @@ namespace ozToy::AST {
 		case TokenType::LET:
 		case TokenType::VAR:
 		{
-			auto expression = DeclarationVariable::parse(scanner, errorOut);
+			auto expression = DeclarationVariable::parse(scanner, arena, errorOut);
 			if (expression == nullptr)
 				return nullptr;
 			return expression;
 		}
+		case TokenType::ERROR:
+			errorOut << scanner->getLocation(token) << ": " << token.text << std::endl;
+			return nullptr;
 		default:
-			return new NOPExpression();
+			return NOPExpression::getInstance();
 		}
 	}
 
-	Expression* Expression::parseLine(Scanner* scanner, std::ostream& errorOut)
+	Expression* Expression::parseCall(Scanner* scanner, Arena& arena, Expression* callee, std::ostream& errorOut)
 	{
-		std::stack<Expression*> expressionStack;
-		std::stack<BinaryOperatorType> operatorStack;
+		auto leftParen = scanner->getToken();
 
-		auto primary = parsePrimary(scanner, errorOut);
-		if (primary == nullptr)
+		// Arguments of the calls being parsed on this thread, each call above where it started
+		thread_local std::vector<Expression*> pending;
+		std::size_t first = pending.size();
+		if (scanner->peekToken().type != TokenType::RIGHT_PAREN)
+		{
+			while (true) {
+				auto argument = parseOperators(scanner, arena, BindingPower::MinPower, errorOut);
+				if (argument == nullptr)
+				{
+					pending.resize(first);
+					return nullptr;
+				}
+				pending.push_back(argument);
+				if (scanner->peekToken().type != TokenType::COMMA)
+					break;
+				scanner->consumeToken(); // Consume the ,
+			}
+		}
+
+		auto rightParen = scanner->getToken();
+		if (rightParen.type != TokenType::RIGHT_PAREN)
+		{
+			errorOut << scanner->getLocation(rightParen) << ": Expected ), got " << rightParen.toString() << std::endl;
+			pending.resize(first);
 			return nullptr;
-		expressionStack.push(primary);
-		operatorStack.push(BinaryOperatorType::START);
+		}
+
+		ArenaSpan<Expression*> arguments;
+		arguments.size = pending.size() - first;
+		if (arguments.size != 0)
+		{
+			arguments.data = static_cast<Expression**>(arena.allocate(sizeof(Expression*) * arguments.size, alignof(Expression*)));
+			std::copy(pending.begin() + first, pending.end(), arguments.data);
+		}
+		pending.resize(first);
+		return withOffset(arena.create<CallExpression>(callee, arguments), leftParen.offset);
+	}
+
+	Expression* Expression::parseOperators(Scanner* scanner, Arena& arena, std::uint8_t minPower, std::ostream& errorOut)
+	{
+		Expression* left;
+		Token token = scanner->peekToken();
+		const BindingPower::Unary& prefix = BindingPower::prefix(token.type);
+		if (prefix.power != BindingPower::None)
+		{
+			scanner->consumeToken();
+			auto operand = parseOperators(scanner, arena, prefix.power, errorOut);
+			if (operand == nullptr)
+				return nullptr;
+			left = withOffset(arena.create<UnaryExpression>(operand, prefix.type), token.offset);
+		}
+		else
+		{
+			left = parsePrimary(scanner, arena, errorOut);
+			if (left == nullptr)
+				return nullptr;
+		}
 
 		while (true) {
-			Token token = scanner->peekToken();
-			BinaryOperatorType operatorType = binaryOperatorTypeFromTokenType(token.type);
-			BinaryOperatorType topOperatorType = operatorStack.top();
-
-			ExpressionParseOperation operation = getOperation(topOperatorType, operatorType);
-			switch (operation) {
-			case ExpressionParseOperation::SHIFT:
-				scanner->consumeToken();
-				operatorStack.push(operatorType);
+			token = scanner->peekToken();
+
+			std::uint8_t postfix = BindingPower::postfix(token.type);
+			if (postfix != BindingPower::None)
+			{
+				if (postfix < minPower)
+					break;
+				if (token.type == TokenType::LEFT_PAREN)
 				{
-					auto primary = parsePrimary(scanner, errorOut);
-					if (primary == nullptr) {
-						while (!expressionStack.empty()) {
-							delete expressionStack.top();
-							expressionStack.pop();
-						}
+					left = parseCall(scanner, arena, left, errorOut);
+					if (left == nullptr)
 						return nullptr;
-					}
-					expressionStack.push(primary);
+					continue;
 				}
+
+				scanner->consumeToken(); // Consume the [
+				auto index = parseOperators(scanner, arena, BindingPower::MinPower, errorOut);
+				if (index == nullptr)
+					return nullptr;
+				auto rightBracket = scanner->getToken();
+				if (rightBracket.type != TokenType::RIGHT_BRACKET)
+				{
+					errorOut << scanner->getLocation(rightBracket) << ": Expected ], got " << rightBracket.toString() << std::endl;
+					return nullptr;
+				}
+				left = withOffset(arena.create<IndexExpression>(left, index), token.offset);
 				continue;
-			case ExpressionParseOperation::REDUCE:
-			{
-				auto right = expressionStack.top();
-				expressionStack.pop();
-				auto left = expressionStack.top();
-				expressionStack.pop();
-				auto operatorType = operatorStack.top();
-				operatorStack.pop();
-				expressionStack.push(new BinaryExpression(left, right, operatorType));
 			}
-			continue;
-			case ExpressionParseOperation::ACCEPT:
+
+			const BindingPower::Infix& infix = BindingPower::infix(token.type);
+			if (infix.left == BindingPower::None || infix.left < minPower)
 				break;
-			default:
-				errorOut << "Unexpected token " << token.toString() << std::endl;
-				while (!expressionStack.empty()) {
-					delete expressionStack.top();
-					expressionStack.pop();
-				}
+			scanner->consumeToken();
+			auto right = parseOperators(scanner, arena, infix.right, errorOut);
+			if (right == nullptr)
 				return nullptr;
-			}
-
-			break;
+			left = withOffset(arena.create<BinaryExpression>(left, right, infix.type), token.offset);
 		}
 
-		return expressionStack.top();
+		return left;
 	}
 
-	Expression* Expression::parse(Scanner* scanner, std::ostream& errorOut)
+	Expression* Expression::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut)
 	{
-		Expression* expression = parseLine(scanner, errorOut);
+		Expression* expression = parseOperators(scanner, arena, BindingPower::MinPower, errorOut);
 		if (expression == nullptr)
 			return nullptr;
 
-		while (true) {
-			if (scanner->peekToken().type != TokenType::SEMICOLON) break;
+		if (scanner->peekToken().type != TokenType::SEMICOLON)
+			return expression;
 
+		std::vector<Expression*> statements;
+		statements.push_back(expression);
+		while (scanner->peekToken().type == TokenType::SEMICOLON) {
 			scanner->consumeToken(); // Consume the ;
 
-			auto nextExpression = parseLine(scanner, errorOut);
+			auto nextExpression = parseOperators(scanner, arena, BindingPower::MinPower, errorOut);
 			if (nextExpression == nullptr)
-			{
-				delete expression;
 				return nullptr;
-			}
-			expression = new SemicolonExpression(expression, nextExpression);
+			statements.push_back(nextExpression);
 		}
 
-		return expression;
-	}
-
-	ozToy::HIR::Value* DeclarationVariable::generateHIR(HIR::FunctionBuilder& fBuilder)
-	{
-		if (typeIsInferred)
-			return fBuilder.declVariable(this->name, false);
-		else
-			return fBuilder.declVariable(this->name, this->type, false);
+		return withOffset(arena.create<SequenceExpression>(arena.copy(statements)), expression->getOffset());
 	}
 
-	DeclarationVariable* DeclarationVariable::parse(Scanner* scanner, std::ostream& errorOut)
+	DeclarationVariable* DeclarationVariable::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut)
 	{
-		bool isMutable = scanner->getToken().type == TokenType::VAR;
+		auto keyword = scanner->getToken();
+		bool isMutable = keyword.type == TokenType::VAR;
 
 		auto name = scanner->getToken();
 		if (name.type != TokenType::IDENTIFIER)
 		{
-			errorOut << "Expected variable name, got " << name.toString() << std::endl;
+			errorOut << scanner->getLocation(name) << ": Expected variable name, got " << name.toString() << std::endl;
 			return nullptr;
 		}
 
 		if (scanner->peekToken().type != TokenType::COLON) {
-			return new DeclarationVariable(name.text, isMutable);
+			return withOffset(arena.create<DeclarationVariable>(name.symbol, isMutable), keyword.offset);
 		}
 
 		scanner->consumeToken(); // Consume the :
@@ -429,93 +672,248 @@ namespace ozToy::AST {
 		auto type = scanner->getToken();
 		if (type.type != TokenType::IDENTIFIER)
 		{
-			errorOut << "Expected variable type, got " << type.toString() << std::endl;
+			errorOut << scanner->getLocation(type) << ": Expected variable type, got " << type.toString() << std::endl;
 			return nullptr;
 		}
 
-		return new DeclarationVariable(name.text, type.text, isMutable);
+		return withOffset(arena.create<DeclarationVariable>(name.symbol, arena.copy(type.text), isMutable), keyword.offset);
 	}
 
-	ozToy::HIR::Value* BlockExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
+	BlockExpression* BlockExpression::parse(Scanner* scanner, Arena& arena, std::ostream& errorOut)
 	{
-		fBuilder.createBlock();
-		fBuilder.addInstruction(this->inner->generateHIR(fBuilder));
-		return fBuilder.exitBlock();
-	}
-
-	BlockExpression::~BlockExpression()
-	{
-		delete this->inner;
-	}
-
-	BlockExpression* BlockExpression::parse(Scanner* scanner, std::ostream& errorOut)
-	{
-		scanner->consumeToken(); // Consume the {
+		auto leftBrace = scanner->getToken();
 
-		auto expression = Expression::parse(scanner, errorOut);
+		auto expression = Expression::parse(scanner, arena, errorOut);
 		if (expression == nullptr)
 			return nullptr;
 
-		if (scanner->getToken().type != TokenType::RIGHT_BRACE)
+		auto rightBrace = scanner->getToken();
+		if (rightBrace.type != TokenType::RIGHT_BRACE)
 		{
-			errorOut << "Expected }, got " << scanner->getToken().toString() << std::endl;
-			delete expression;
+			errorOut << scanner->getLocation(rightBrace) << ": Expected }, got " << rightBrace.toString() << std::endl;
 			return nullptr;
 		}
 
-		return new BlockExpression(expression);
+		return withOffset(arena.create<BlockExpression>(expression), leftBrace.offset);
 	}
 
-	ozToy::HIR::Value* SemicolonExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
+	NOPExpression* NOPExpression::getInstance()
 	{
-		fBuilder.addInstruction(this->previous->generateHIR(fBuilder));
-		return this->next->generateHIR(fBuilder);
+		static NOPExpression* instance = new NOPExpression();
+		return instance;
 	}
 
-	SemicolonExpression::~SemicolonExpression()
-	{
-		delete this->previous;
-		delete this->next;
-	}
+	namespace {
+		// Declarations into the module builder, expressions into the current function's builder
+		class HIRGenerator : public TopLevelVisitor<HIRGenerator>, public ExpressionVisitor<HIRGenerator, HIR::Value*>
+		{
+			HIR::ModuleBuilder* mBuilder;
+			HIR::FunctionBuilder* fBuilder;
+			bool failed = false;
+		public:
+			using TopLevelVisitor<HIRGenerator>::visit;
+			using ExpressionVisitor<HIRGenerator, HIR::Value*>::visit;
+
+			HIRGenerator(HIR::ModuleBuilder* mBuilder, HIR::FunctionBuilder* fBuilder = nullptr) : mBuilder(mBuilder), fBuilder(fBuilder) {}
+			// Whether a function body could not be parsed
+			bool hasFailed() const { return failed; }
+
+			void visitModule(const Module* node)
+			{
+				HIR::ModuleBuilder m(mBuilder->getModule().createModule(std::string(node->getName())));
+				HIR::ModuleBuilder* outer = mBuilder;
+				mBuilder = &m;
+				for (auto topLevel : node->getTopLevel())
+				{
+					visit(topLevel);
+				}
+				mBuilder = outer;
+			}
 
-	ozToy::HIR::Value* NumberExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
-	{
-		return fBuilder.getLiteral(this->value, HIR::LiteralType::INT);
-	}
+			void visitFunction(const DeclarationFunction* node)
+			{
+				HIR::FunctionBuilder f(mBuilder->getModule().createFunction(std::string(node->getName())));
+				for (auto argument : node->getArguments())
+				{
+					f.addArgument(std::string(argument->getName()), std::string(argument->getType()));
+				}
+				f.setReturnType(std::string(node->getReturnType()));
 
-	HIR::Value* StringExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
-	{
-		return fBuilder.getLiteral(this->value, HIR::LiteralType::STRING);
-	}
+				// A lazy body that does not parse leaves the function empty
+				BlockExpression* body = node->getBody();
+				if (body == nullptr)
+				{
+					failed = true;
+					return;
+				}
+				HIR::FunctionBuilder* outer = fBuilder;
+				fBuilder = &f;
+				f.addInstruction(visit(body));
+				fBuilder = outer;
+			}
 
-	HIR::Value* CharExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
-	{
-		return fBuilder.getLiteral(this->value, HIR::LiteralType::CHAR);
+			HIR::Value* visitDeclarationVariable(const DeclarationVariable* node)
+			{
+				if (node->getTypeIsInferred())
+					return withOffset(fBuilder->declVariable(node->getName(), false), node->getOffset());
+				else
+					return withOffset(fBuilder->declVariable(node->getName(), std::string(node->getType()), false), node->getOffset());
+			}
+
+			HIR::Value* visitBlock(const BlockExpression* node)
+			{
+				fBuilder->createBlock();
+				fBuilder->addInstruction(visit(node->getInner()));
+				return withOffset(fBuilder->exitBlock(), node->getOffset());
+			}
+
+			HIR::Value* visitSequence(const SequenceExpression* node)
+			{
+				const ArenaSpan<Expression*>& statements = node->getStatements();
+				for (std::size_t i = 0; i + 1 < statements.size; ++i)
+				{
+					fBuilder->addInstruction(visit(statements[i]));
+				}
+				return visit(statements[statements.size - 1]);
+			}
+
+			// Literals come from the unit's constant pool and are shared, so they take no offset
+			HIR::Value* visitNumber(const NumberExpression* node)
+			{
+				if (node->getIsFloat())
+					return fBuilder->getFloat(floatFromBits(node->getValue()));
+				return fBuilder->getInteger(node->getValue());
+			}
+
+			HIR::Value* visitString(const StringExpression* node)
+			{
+				return fBuilder->getString(node->getValue());
+			}
+
+			HIR::Value* visitChar(const CharExpression* node)
+			{
+				return fBuilder->getChar(node->getValue());
+			}
+
+			HIR::Value* visitIdentifier(const IdentifierExpression* node)
+			{
+				return fBuilder->getVariable(node->getValue());
+			}
+
+			HIR::Value* visitBinary(const BinaryExpression* node)
+			{
+				HIR::Value* hir_left, *hir_right;
+				if (evaluatesRightFirst(node->getType())) {
+					hir_right = visit(node->getRight());
+					hir_left = visit(node->getLeft());
+				}
+				else {
+					hir_left = visit(node->getLeft());
+					hir_right = visit(node->getRight());
+				}
+				return withOffset(fBuilder->binaryOp(node->getType(), hir_left, hir_right), node->getOffset());
+			}
+
+			HIR::Value* visitUnary(const UnaryExpression* node)
+			{
+				HIR::Value* hir_operand = visit(node->getOperand());
+				return withOffset(fBuilder->unaryOp(node->getType(), hir_operand), node->getOffset());
+			}
+
+			HIR::Value* visitCall(const CallExpression* node)
+			{
+				HIR::Value* hir_callee = visit(node->getCallee());
+				std::vector<HIR::Value*> hir_arguments;
+				hir_arguments.reserve(node->getArguments().size);
+				for (auto argument : node->getArguments())
+					hir_arguments.push_back(visit(argument));
+				return withOffset(fBuilder->call(hir_callee, hir_arguments), node->getOffset());
+			}
+
+			HIR::Value* visitIndex(const IndexExpression* node)
+			{
+				HIR::Value* hir_target = visit(node->getTarget());
+				HIR::Value* hir_index = visit(node->getIndex());
+				return withOffset(fBuilder->index(hir_target, hir_index), node->getOffset());
+			}
+
+			HIR::Value* visitNop(const NOPExpression*)
+			{
+				return HIR::UnitTypeValue::getInstance();
+			}
+		};
 	}
 
-	HIR::Value* BinaryExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
+	bool Root::generateHIR(HIR::ModuleBuilder& mBuilder) const
 	{
-		HIR::Value* hir_left, *hir_right;
-		if (BinaryOperatorPriority[static_cast<size_t>(type)] == 1) {
-			hir_right = right->generateHIR(fBuilder);
-			hir_left = left->generateHIR(fBuilder);
-		}
-		else {
-			hir_left = left->generateHIR(fBuilder);
-			hir_right = right->generateHIR(fBuilder);
+		HIRGenerator generator(&mBuilder);
+		for (auto& topLevel : this->topLevel)
+		{
+			generator.visit(topLevel);
 		}
+		return !generator.hasFailed();
+	}
+
+	namespace {
+		// The items of one module body, or of the file when nested is false
+		bool compileItems(Scanner* scanner, Arena& arena, HIR::ModuleBuilder& mBuilder, bool nested, std::size_t& peakBytes, std::ostream& errorOut)
+		{
+			while (true)
+			{
+				Token token = scanner->peekToken();
+				if (nested && token.type == TokenType::RIGHT_BRACE)
+				{
+					scanner->consumeToken(); // Consume the }
+					return true;
+				}
+				if (!nested && token.type == TokenType::END_OF_FILE)
+					return true;
 
-		return new HIR::Call(fBuilder.getVariable("binary"), { hir_left, hir_right });
+				if (token.type == TokenType::MODULE)
+				{
+					Token keyword;
+					Token name;
+					if (!parseModuleHeader(scanner, keyword, name, errorOut))
+						return false;
+					HIR::ModuleBuilder m(mBuilder.getModule().createModule(std::string(name.text)));
+					if (!compileItems(scanner, arena, m, true, peakBytes, errorOut))
+						return false;
+					continue;
+				}
+
+				// A function, or the same diagnostic as the whole-file parser
+				auto item = TopLevel::parse(scanner, arena, errorOut);
+				if (item == nullptr)
+					return false;
+				HIRGenerator generator(&mBuilder);
+				generator.visit(item);
+				if (generator.hasFailed())
+					return false;
+				peakBytes = std::max(peakBytes, arena.getBytesAllocated());
+				arena.reset();
+			}
+		}
 	}
 
-	HIR::Value* NOPExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
+	bool Root::compileStreaming(Scanner* scanner, HIR::ModuleBuilder& mBuilder, std::ostream& errorOut, std::size_t* peakBytes)
 	{
-		return HIR::UnitTypeValue::getInstance();
+		Arena arena;
+		std::size_t peak = 0;
+		bool compiled = compileItems(scanner, arena, mBuilder, false, peak, errorOut);
+		if (peakBytes != nullptr)
+			*peakBytes = peak;
+		return compiled;
 	}
 
-	HIR::Value* IdentifierExpression::generateHIR(HIR::FunctionBuilder& fBuilder)
+	bool TopLevel::generateHIR(HIR::ModuleBuilder& mBuilder) const
 	{
-		return fBuilder.getVariable(this->value);
+		HIRGenerator generator(&mBuilder);
+		generator.visit(this);
+		return !generator.hasFailed();
 	}
 
+	HIR::Value* Expression::generateHIR(HIR::FunctionBuilder& fBuilder) const
+	{
+		return HIRGenerator(nullptr, &fBuilder).visit(this);
+	}
 }
\ No newline at end of file
@@ -1,169 +1,260 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "Arena.hpp"
+#include "BindingPower.hpp"
+#include "FlatAST.hpp"
 #include "HIRBuilder.hpp"
+#include "StructuralHash.hpp"
 
 #include "Scanner.hpp"
+#include "TokenStream.hpp"
 
 namespace ozToy::AST {
+	// Walked with the visitors in ASTVisitor.hpp. Nodes live in their Root's Arena, so every node
+	// but Root must stay trivially destructible.
 	class Node {
+		// Of the node's first token
+		std::uint32_t offset = 0;
+		NodeKind kind;
+		// A byte of per-kind data, like FlatTree's tag
+		std::uint8_t tag;
+	protected:
+		explicit Node(NodeKind kind, std::uint8_t tag = 0) : kind(kind), tag(tag) {}
+		~Node() = default;
+		std::uint8_t getTag() const { return tag; }
 	public:
-		virtual ~Node() = default;
+		NodeKind getKind() const { return kind; }
+		std::uint32_t getOffset() const { return offset; }
+		void setOffset(std::uint32_t offset) { this->offset = offset; }
 	};
 
-	class TopLevel : public virtual Node {
+	// LAZY parses each function body on first use; it needs a Scanner over a TokenStream
+	enum class BodyParsing : std::uint8_t {
+		EAGER,
+		LAZY,
+	};
+
+	class TopLevel : public Node {
+	protected:
+		explicit TopLevel(NodeKind kind) : Node(kind) {}
+		~TopLevel() = default;
 	public:
-		virtual ~TopLevel() = default;
-		virtual void generateHIR(HIR::ModuleBuilder& mBuilder) = 0;
-		static TopLevel* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		// False when a lazy function body does not parse
+		bool generateHIR(HIR::ModuleBuilder& mBuilder) const;
+		static TopLevel* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr, BodyParsing bodies = BodyParsing::EAGER);
 	};
 
-	class Root : public virtual Node {
+	// Owns the arena the rest of the tree lives in
+	class Root final : public Node {
+		Arena arena;
+		// One per parseParallel worker, for the functions it parsed
+		std::vector<Arena*> workerArenas;
 		std::vector<TopLevel*> topLevel;
 	public:
 		Root();
+		~Root();
 		void addTopLevel(TopLevel* topLevel);
-		void generateHIR(HIR::ModuleBuilder& builder);
-		virtual ~Root();
-		static Root* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		// False when a lazy function body does not parse, like TopLevel::generateHIR
+		bool generateHIR(HIR::ModuleBuilder& builder) const;
+		const Arena& getArena() const { return arena; }
+		const std::vector<TopLevel*>& getTopLevel() const { return topLevel; }
+		static Root* parse(Scanner* scanner, std::ostream& errorOut = std::cerr, BodyParsing bodies = BodyParsing::EAGER);
+		// Same tree and diagnostics as parse(); threadCount 0 means one per core
+		static Root* parseParallel(TokenStream* stream, std::size_t threadCount = 0, std::ostream& errorOut = std::cerr);
+		// Parses, lowers and frees one fn at a time; stops at the first error.
+		// peakBytes receives the most AST bytes held at once.
+		static bool compileStreaming(Scanner* scanner, HIR::ModuleBuilder& mBuilder, std::ostream& errorOut = std::cerr, std::size_t* peakBytes = nullptr);
 	};
 
-	class Expression : public virtual Node {
-		static Expression* parsePrimary(Scanner* scanner, std::ostream& errorOut = std::cerr);
-		static Expression* parseLine(Scanner* scanner, std::ostream& errorOut = std::cerr);
+	class Expression : public Node {
+		static Expression* parsePrimary(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr);
+		// Pratt loop: parses operators binding at least minPower, see BindingPower.hpp
+		static Expression* parseOperators(Scanner* scanner, Arena& arena, std::uint8_t minPower, std::ostream& errorOut = std::cerr);
+		static Expression* parseCall(Scanner* scanner, Arena& arena, Expression* callee, std::ostream& errorOut = std::cerr);
+	protected:
+		explicit Expression(NodeKind kind, std::uint8_t tag = 0) : Node(kind, tag) {}
+		~Expression() = default;
 	public:
-		virtual HIR::Value* generateHIR(HIR::FunctionBuilder & fBuilder) = 0;
-		virtual ~Expression() = default;
-		static Expression* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) const;
+		static Expression* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr);
 	};
 
-	class Argument : public virtual Node {
-		std::string name;
-		std::string type;
+	class Argument : public Node {
+		std::string_view name;
+		std::string_view type;
 	public:
-		Argument(std::string name, std::string type) : name(name), type(type) {}
-		virtual ~Argument() = default;
-		const std::string& getName() const { return name; }
-		const std::string& getType() const { return type; }
-		static Argument* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		Argument(std::string_view name, std::string_view type) : Node(NodeKind::ARGUMENT), name(name), type(type) {}
+		std::string_view getName() const { return name; }
+		std::string_view getType() const { return type; }
+		static Argument* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr);
 	};
 
 	class BlockExpression;
 
-	class DeclarationFunction : public virtual TopLevel {
-		std::string name;
-		std::vector<Argument*> arguments;
-		std::string returnType;
-		BlockExpression* body = nullptr;
+	// Where a lazily parsed body starts, and the arena to parse it into
+	struct LazyBody
+	{
+		TokenStream* stream;
+		Arena* arena;
+		// Index of the body's {
+		std::size_t begin;
+	};
+
+	class DeclarationFunction : public TopLevel {
+		std::string_view name;
+		ArenaSpan<Argument*> arguments;
+		std::string_view returnType;
+		mutable BlockExpression* body = nullptr;
+		mutable const LazyBody* lazyBody = nullptr;
+		// Set once the body is parsed, see StructuralHash.hpp
+		mutable Hash128 hash;
+		// Table to hash with after a piped parse, else null
+		mutable const SymbolTable* unhashedSymbols = nullptr;
 	public:
-		DeclarationFunction(std::string name) : name(name) {}
-		void addArgument(Argument* argument);
-		void setReturnType(std::string returnType);
+		DeclarationFunction(std::string_view name) : TopLevel(NodeKind::DECLARATION_FUNCTION), name(name) {}
+		void setArguments(ArenaSpan<Argument*> arguments);
+		void setReturnType(std::string_view returnType);
 		void setBody(BlockExpression* body);
-		void generateHIR(HIR::ModuleBuilder& mBuilder) override;
-		virtual ~DeclarationFunction();
-		static DeclarationFunction* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		std::string_view getName() const { return name; }
+		const ArenaSpan<Argument*>& getArguments() const { return arguments; }
+		std::string_view getReturnType() const { return returnType; }
+		// False if a lazy body does not parse; it is not retried
+		bool parseBody(std::ostream& errorOut = std::cerr) const;
+		BlockExpression* getBody() const { return parseBody() ? body : nullptr; }
+		// After a piped parse, only once the parse has returned
+		Hash128 getHash() const;
+		static DeclarationFunction* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr, BodyParsing bodies = BodyParsing::EAGER);
 	};
 
-	class Module : public virtual TopLevel {
-		std::string name;
-		std::vector<TopLevel*> topLevel;
+	class Module : public TopLevel {
+		std::string_view name;
+		ArenaSpan<TopLevel*> topLevel;
+		// Computed at the end of an eager parse, otherwise on first request
+		mutable Hash128 hash;
+		mutable bool hashed = false;
 	public:
-		Module(std::string name) : name(name) {}
-		void addTopLevel(TopLevel* topLevel);
-		void generateHIR(HIR::ModuleBuilder& mBuilder) override;
-		virtual ~Module();
-		static Module* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		Module(std::string_view name) : TopLevel(NodeKind::MODULE), name(name) {}
+		void setTopLevel(ArenaSpan<TopLevel*> topLevel);
+		std::string_view getName() const { return name; }
+		const ArenaSpan<TopLevel*>& getTopLevel() const { return topLevel; }
+		// Parses the lazy bodies inside first
+		Hash128 getHash() const;
+		static Module* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr, BodyParsing bodies = BodyParsing::EAGER);
 	};
 
-	class DeclarationVariable : public virtual Expression {
-		std::string name;
-		std::string type;
-		bool isMutable;
-		bool typeIsInferred;
+	class DeclarationVariable : public Expression {
+		// Tag bits
+		static constexpr std::uint8_t Mutable = 1;
+		static constexpr std::uint8_t TypeIsInferred = 2;
+		SymbolId name;
+		// The type's spelling, split to pack next to name
+		std::uint32_t typeLength;
+		const char* typeText;
 	public:
-		DeclarationVariable(std::string name, std::string type, bool isMutable) : name(name), type(type), isMutable(isMutable), typeIsInferred(false) {}
-		DeclarationVariable(std::string name, bool isMutable) : name(name), isMutable(isMutable), typeIsInferred(true) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~DeclarationVariable() = default;
-		static DeclarationVariable* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		DeclarationVariable(SymbolId name, std::string_view type, bool isMutable) : Expression(NodeKind::DECLARATION_VARIABLE, isMutable ? Mutable : 0), name(name), typeLength(static_cast<std::uint32_t>(type.size())), typeText(type.data()) {}
+		DeclarationVariable(SymbolId name, bool isMutable) : Expression(NodeKind::DECLARATION_VARIABLE, TypeIsInferred | (isMutable ? Mutable : 0)), name(name), typeLength(0), typeText(nullptr) {}
+		SymbolId getName() const { return name; }
+		// Empty when the type is inferred
+		std::string_view getType() const { return std::string_view(typeText, typeLength); }
+		bool getIsMutable() const { return (getTag() & Mutable) != 0; }
+		bool getTypeIsInferred() const { return (getTag() & TypeIsInferred) != 0; }
+		static DeclarationVariable* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr);
 	};
 
-	class BlockExpression : public virtual Expression {
+	class BlockExpression : public Expression {
 		Expression* inner;
 	public:
-		BlockExpression(Expression* inner) : inner(inner) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~BlockExpression();
-		static BlockExpression* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		BlockExpression(Expression* inner) : Expression(NodeKind::BLOCK), inner(inner) {}
+		Expression* getInner() const { return inner; }
+		static BlockExpression* parse(Scanner* scanner, Arena& arena, std::ostream& errorOut = std::cerr);
 	};
 
-	class SemicolonExpression : public virtual Expression {
-		Expression* previous;
-		Expression* next;
+	// a; b; c
+	class SequenceExpression : public Expression {
+		ArenaSpan<Expression*> statements;
 	public:
-		SemicolonExpression(Expression* prev, Expression* next) : previous(prev), next(next) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~SemicolonExpression();
+		SequenceExpression(ArenaSpan<Expression*> statements) : Expression(NodeKind::SEQUENCE), statements(statements) {}
+		const ArenaSpan<Expression*>& getStatements() const { return statements; }
 	};
 
-	class NumberExpression : public virtual Expression {
-		std::string value;
+	// A float is kept as the bits of its double
+	class NumberExpression : public Expression {
+		// The tag is isFloat
+		std::uint64_t value;
 	public:
-		NumberExpression(std::string value) : value(value) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~NumberExpression() = default;
+		NumberExpression(std::uint64_t value, bool isFloat) : Expression(NodeKind::NUMBER, isFloat), value(value) {}
+		bool getIsFloat() const { return getTag() != 0; }
+		std::uint64_t getValue() const { return value; }
 	};
 
-	class StringExpression : public virtual Expression {
-		std::string value;
+	class StringExpression : public Expression {
+		std::string_view value;
 	public:
-		StringExpression(std::string value) : value(value) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~StringExpression() = default;
+		StringExpression(std::string_view value) : Expression(NodeKind::STRING), value(value) {}
+		std::string_view getValue() const { return value; }
 	};
 
-	class CharExpression : public virtual Expression {
-		std::string value;
+	class CharExpression : public Expression {
+		std::string_view value;
 	public:
-		CharExpression(std::string value) : value(value) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~CharExpression() = default;
+		CharExpression(std::string_view value) : Expression(NodeKind::CHAR), value(value) {}
+		std::string_view getValue() const { return value; }
 	};
 
-	class IdentifierExpression : public virtual Expression {
-		std::string value;
+	class IdentifierExpression : public Expression {
+		SymbolId value;
 	public:
-		IdentifierExpression(std::string value) : value(value) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~IdentifierExpression() = default;
+		IdentifierExpression(SymbolId value) : Expression(NodeKind::IDENTIFIER), value(value) {}
+		SymbolId getValue() const { return value; }
 	};
 
-	class CallExpression : public virtual Expression {
+	class CallExpression : public Expression {
 		Expression* callee;
-		std::vector<Expression*> arguments;
+		ArenaSpan<Expression*> arguments;
 	public:
-		virtual ~CallExpression() = default;
-		static CallExpression* parse(Scanner* scanner, std::ostream& errorOut = std::cerr);
+		CallExpression(Expression* callee, ArenaSpan<Expression*> arguments) : Expression(NodeKind::CALL), callee(callee), arguments(arguments) {}
+		Expression* getCallee() const { return callee; }
+		const ArenaSpan<Expression*>& getArguments() const { return arguments; }
 	};
 
-	class BinaryExpression : public virtual Expression {
+	class IndexExpression : public Expression {
+		Expression* target;
+		Expression* index;
+	public:
+		IndexExpression(Expression* target, Expression* index) : Expression(NodeKind::INDEX), target(target), index(index) {}
+		Expression* getTarget() const { return target; }
+		Expression* getIndex() const { return index; }
+	};
+
+	class UnaryExpression : public Expression {
+		// The tag is the UnaryOperatorType
+		Expression* operand;
+	public:
+		UnaryExpression(Expression* operand, UnaryOperatorType type) : Expression(NodeKind::UNARY, static_cast<std::uint8_t>(type)), operand(operand) {}
+		UnaryOperatorType getType() const { return static_cast<UnaryOperatorType>(getTag()); }
+		Expression* getOperand() const { return operand; }
+	};
+
+	class BinaryExpression : public Expression {
+		// The tag is the BinaryOperatorType
 		Expression* left;
 		Expression* right;
-		BinaryOperatorType type;
 	public:
-		BinaryExpression(Expression* left, Expression* right, BinaryOperatorType type) : left(left), right(right), type(type) {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~BinaryExpression() = default;
+		BinaryExpression(Expression* left, Expression* right, BinaryOperatorType type) : Expression(NodeKind::BINARY, static_cast<std::uint8_t>(type)), left(left), right(right) {}
+		BinaryOperatorType getType() const { return static_cast<BinaryOperatorType>(getTag()); }
+		Expression* getLeft() const { return left; }
+		Expression* getRight() const { return right; }
 	};
 
-	class NOPExpression : public virtual Expression {
-
+	// Shared by every parse; it has no position and nothing may set one
+	class NOPExpression : public Expression {
+		NOPExpression() : Expression(NodeKind::NOP) {}
 	public:
-		NOPExpression() {}
-		HIR::Value* generateHIR(HIR::FunctionBuilder& fBuilder) override;
-		virtual ~NOPExpression() = default;
+		static NOPExpression* getInstance();
 	};
 }
@@ -0,0 +1,77 @@
+#include "ASTDiff.hpp"
+
+#include <unordered_map>
+#include <utility>
+
+#include "ASTVisitor.hpp"
+
+namespace ozToy::AST {
+
+	namespace {
+		class FunctionCollector : public TopLevelVisitor<FunctionCollector>
+		{
+			std::string prefix;
+		public:
+			std::vector<std::pair<std::string, const DeclarationFunction*>> functions;
+
+			void visitModule(const Module* node)
+			{
+				std::size_t length = prefix.size();
+				prefix.append(node->getName());
+				prefix.append("::");
+				for (auto topLevel : node->getTopLevel())
+					visit(topLevel);
+				prefix.resize(length);
+			}
+
+			void visitFunction(const DeclarationFunction* node)
+			{
+				functions.emplace_back(prefix + std::string(node->getName()), node);
+			}
+		};
+
+		std::vector<std::pair<std::string, const DeclarationFunction*>> collectFunctions(const Root* root)
+		{
+			FunctionCollector collector;
+			for (auto topLevel : root->getTopLevel())
+				collector.visit(topLevel);
+			return std::move(collector.functions);
+		}
+	}
+
+	FunctionChanges diffFunctions(const Root* before, const Root* after)
+	{
+		auto oldFunctions = collectFunctions(before);
+		auto newFunctions = collectFunctions(after);
+
+		// Indices into oldFunctions per name, and how many are matched
+		std::unordered_map<std::string, std::pair<std::vector<std::size_t>, std::size_t>> byName;
+		for (std::size_t i = 0; i < oldFunctions.size(); ++i)
+			byName[oldFunctions[i].first].first.push_back(i);
+
+		FunctionChanges changes;
+		std::vector<bool> matched(oldFunctions.size(), false);
+		for (auto& function : newFunctions)
+		{
+			auto it = byName.find(function.first);
+			if (it == byName.end() || it->second.second == it->second.first.size())
+			{
+				changes.added.push_back(std::move(function.first));
+				continue;
+			}
+			std::size_t old = it->second.first[it->second.second++];
+			matched[old] = true;
+			if (oldFunctions[old].second->getHash() == function.second->getHash())
+				changes.unchanged.push_back(function.second);
+			else
+				changes.changed.push_back(std::move(function.first));
+		}
+
+		for (std::size_t i = 0; i < oldFunctions.size(); ++i)
+		{
+			if (!matched[i])
+				changes.removed.push_back(std::move(oldFunctions[i].first));
+		}
+		return changes;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+
+namespace ozToy::AST {
+
+	// Functions are matched by qualified name, "outer::inner::f", then by source order
+	struct FunctionChanges
+	{
+		std::vector<std::string> added;
+		std::vector<std::string> removed;
+		std::vector<std::string> changed;
+		// Anything derived from the old function is still valid for these
+		std::vector<const DeclarationFunction*> unchanged;
+	};
+
+	// Compares two parses of a file by structural hash, in source order
+	FunctionChanges diffFunctions(const Root* before, const Root* after);
+}
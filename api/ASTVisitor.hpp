@@ -0,0 +1,93 @@
+#pragma once
+
+#include "AST.hpp"
+
+// After a switch that lists every NodeKind, instead of a default
+#ifdef _MSC_VER
+#define OZTOY_UNREACHABLE() __assume(0)
+#else
+#define OZTOY_UNREACHABLE() __builtin_unreachable()
+#endif
+
+namespace ozToy::AST {
+
+	// Switch on Node::getKind() and call Derived's visitX handler for the node's class.
+	// A pass deriving from both visitors needs a using-declaration for each visit().
+	template <typename Derived, typename Result = void>
+	class ExpressionVisitor
+	{
+	public:
+		Result visit(const Expression* node)
+		{
+			Derived& self = static_cast<Derived&>(*this);
+			switch (node->getKind())
+			{
+			case NodeKind::DECLARATION_VARIABLE:
+				return self.visitDeclarationVariable(static_cast<const DeclarationVariable*>(node));
+			case NodeKind::BLOCK:
+				return self.visitBlock(static_cast<const BlockExpression*>(node));
+			case NodeKind::SEQUENCE:
+				return self.visitSequence(static_cast<const SequenceExpression*>(node));
+			case NodeKind::NUMBER:
+				return self.visitNumber(static_cast<const NumberExpression*>(node));
+			case NodeKind::STRING:
+				return self.visitString(static_cast<const StringExpression*>(node));
+			case NodeKind::CHAR:
+				return self.visitChar(static_cast<const CharExpression*>(node));
+			case NodeKind::IDENTIFIER:
+				return self.visitIdentifier(static_cast<const IdentifierExpression*>(node));
+			case NodeKind::BINARY:
+				return self.visitBinary(static_cast<const BinaryExpression*>(node));
+			case NodeKind::UNARY:
+				return self.visitUnary(static_cast<const UnaryExpression*>(node));
+			case NodeKind::CALL:
+				return self.visitCall(static_cast<const CallExpression*>(node));
+			case NodeKind::INDEX:
+				return self.visitIndex(static_cast<const IndexExpression*>(node));
+			case NodeKind::NOP:
+				return self.visitNop(static_cast<const NOPExpression*>(node));
+			// Not expressions
+			case NodeKind::MODULE:
+			case NodeKind::DECLARATION_FUNCTION:
+			case NodeKind::ARGUMENT:
+			case NodeKind::ROOT:
+				break;
+			}
+			OZTOY_UNREACHABLE();
+		}
+	};
+
+	template <typename Derived, typename Result = void>
+	class TopLevelVisitor
+	{
+	public:
+		Result visit(const TopLevel* node)
+		{
+			Derived& self = static_cast<Derived&>(*this);
+			switch (node->getKind())
+			{
+			case NodeKind::MODULE:
+				return self.visitModule(static_cast<const Module*>(node));
+			case NodeKind::DECLARATION_FUNCTION:
+				return self.visitFunction(static_cast<const DeclarationFunction*>(node));
+			// Not top-level items
+			case NodeKind::ARGUMENT:
+			case NodeKind::DECLARATION_VARIABLE:
+			case NodeKind::BLOCK:
+			case NodeKind::SEQUENCE:
+			case NodeKind::NUMBER:
+			case NodeKind::STRING:
+			case NodeKind::CHAR:
+			case NodeKind::IDENTIFIER:
+			case NodeKind::BINARY:
+			case NodeKind::UNARY:
+			case NodeKind::CALL:
+			case NodeKind::INDEX:
+			case NodeKind::NOP:
+			case NodeKind::ROOT:
+				break;
+			}
+			OZTOY_UNREACHABLE();
+		}
+	};
+}
@@ -0,0 +1,92 @@
+#include "Arena.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace ozToy {
+
+	Arena::Arena(std::size_t chunkSize)
+		: chunks(nullptr), cursor(nullptr), limit(nullptr), chunkSize(chunkSize), allocationCount(0), bytesAllocated(0), bytesReserved(0)
+	{
+	}
+
+	Arena::~Arena()
+	{
+		while (chunks != nullptr)
+		{
+			Chunk* previous = chunks->previous;
+			std::free(chunks);
+			chunks = previous;
+		}
+	}
+
+	void Arena::reset()
+	{
+		// Oversized chunks sit behind the current one
+		Chunk* kept = nullptr;
+		if (chunks != nullptr && chunks->size == chunkSize)
+		{
+			kept = chunks;
+			chunks = chunks->previous;
+		}
+		while (chunks != nullptr)
+		{
+			Chunk* previous = chunks->previous;
+			std::free(chunks);
+			chunks = previous;
+		}
+
+		allocationCount = 0;
+		bytesAllocated = 0;
+		if (kept == nullptr)
+		{
+			cursor = nullptr;
+			limit = nullptr;
+			bytesReserved = 0;
+			return;
+		}
+		kept->previous = nullptr;
+		chunks = kept;
+		cursor = reinterpret_cast<char*>(kept + 1);
+		limit = reinterpret_cast<char*>(kept) + kept->size;
+		bytesReserved = kept->size;
+	}
+
+	void* Arena::allocateSlow(std::size_t size, std::size_t alignment)
+	{
+		// Oversized requests get a chunk of their own
+		std::size_t needed = sizeof(Chunk) + size + alignment;
+		std::size_t newSize = needed > chunkSize ? needed : chunkSize;
+		Chunk* chunk = static_cast<Chunk*>(std::malloc(newSize));
+		if (chunk == nullptr)
+			std::abort();
+		chunk->size = newSize;
+		bytesReserved += newSize;
+
+		char* begin = reinterpret_cast<char*>(chunk + 1);
+		std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(begin) + alignment - 1) & ~(alignment - 1);
+		char* chunkEnd = reinterpret_cast<char*>(chunk) + newSize;
+
+		if (needed > chunkSize && chunks != nullptr)
+		{
+			chunk->previous = chunks->previous;
+			chunks->previous = chunk;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		chunk->previous = chunks;
+		chunks = chunk;
+		cursor = reinterpret_cast<char*>(aligned + size);
+		limit = chunkEnd;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	std::string_view Arena::copy(std::string_view text)
+	{
+		if (text.empty())
+			return std::string_view();
+		char* data = static_cast<char*>(allocate(text.size(), 1));
+		std::memcpy(data, text.data(), text.size());
+		return std::string_view(data, text.size());
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ozToy {
+
+	// Array living in an Arena
+	template <typename T>
+	struct ArenaSpan
+	{
+		T* data = nullptr;
+		std::size_t size = 0;
+		T* begin() const { return data; }
+		T* end() const { return data + size; }
+		bool empty() const { return size == 0; }
+		T& operator[](std::size_t index) const { return data[index]; }
+	};
+
+	// Bump allocator; frees everything at once, so only trivially destructible types go in it
+	class Arena
+	{
+		struct Chunk
+		{
+			Chunk* previous;
+			std::size_t size;
+		};
+
+		static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
+		Chunk* chunks;
+		char* cursor;
+		char* limit;
+		std::size_t chunkSize;
+		std::size_t allocationCount;
+		std::size_t bytesAllocated;
+		std::size_t bytesReserved;
+		void* allocateSlow(std::size_t size, std::size_t alignment);
+	public:
+		explicit Arena(std::size_t chunkSize = DefaultChunkSize);
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+		~Arena();
+
+		void* allocate(std::size_t size, std::size_t alignment)
+		{
+			++allocationCount;
+			bytesAllocated += size;
+			std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+			if (cursor != nullptr && aligned + size <= reinterpret_cast<std::uintptr_t>(limit))
+			{
+				cursor = reinterpret_cast<char*>(aligned + size);
+				return reinterpret_cast<void*>(aligned);
+			}
+			return allocateSlow(size, alignment);
+		}
+
+		template <typename T, typename... Args>
+		T* create(Args&&... args)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+			return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		template <typename T>
+		ArenaSpan<T> copy(const std::vector<T>& items)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Arena arrays are copied bytewise");
+			ArenaSpan<T> span;
+			if (items.empty())
+				return span;
+			span.data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+			span.size = items.size();
+			for (std::size_t i = 0; i < items.size(); ++i)
+				span.data[i] = items[i];
+			return span;
+		}
+
+		std::string_view copy(std::string_view text);
+
+		// Frees everything but one chunk, kept for reuse
+		void reset();
+
+		// Since construction or the last reset()
+		std::size_t getAllocationCount() const { return allocationCount; }
+		std::size_t getBytesAllocated() const { return bytesAllocated; }
+		// Including chunk headers and alignment slack
+		std::size_t getBytesReserved() const { return bytesReserved; }
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "langdef.hpp"
+
+namespace ozToy {
+
+	// Pratt binding powers by TokenType; zero means not an operator in that position
+	namespace BindingPower {
+		constexpr std::uint8_t None = 0;
+		constexpr std::uint8_t MinPower = 1;
+		constexpr std::size_t TokenTypeCount = static_cast<std::size_t>(TokenType::ERROR) + 1;
+
+		constexpr std::uint8_t maxPriority() {
+			std::uint8_t max = 0;
+			for (std::uint8_t priority : BinaryOperatorPriority)
+				max = priority > max ? priority : max;
+			return max;
+		}
+
+		constexpr std::uint8_t Prefix = 2 * maxPriority() + 3;
+		constexpr std::uint8_t Postfix = Prefix + 2;
+
+		struct Infix {
+			std::uint8_t left = None;
+			std::uint8_t right = None;
+			BinaryOperatorType type = BinaryOperatorType::END;
+		};
+
+		struct Unary {
+			std::uint8_t power = None;
+			UnaryOperatorType type = UnaryOperatorType::NOT;
+		};
+
+		constexpr std::array<Infix, TokenTypeCount> buildInfix() {
+			std::array<Infix, TokenTypeCount> table{};
+			for (std::size_t token = 0; token < TokenTypeCount; ++token) {
+				BinaryOperatorType type = binaryOperatorTypeFromTokenType(static_cast<TokenType>(token));
+				if (type == BinaryOperatorType::END)
+					continue;
+				std::uint8_t priority = BinaryOperatorPriority[static_cast<std::size_t>(type)];
+				bool rightAssociative = priority == 1;
+				table[token].left = static_cast<std::uint8_t>(2 * priority + (rightAssociative ? 1 : 0));
+				table[token].right = static_cast<std::uint8_t>(2 * priority + (rightAssociative ? 0 : 1));
+				table[token].type = type;
+			}
+			return table;
+		}
+
+		constexpr std::array<Unary, TokenTypeCount> buildPrefix() {
+			std::array<Unary, TokenTypeCount> table{};
+			table[static_cast<std::size_t>(TokenType::BANG)] = { Prefix, UnaryOperatorType::NOT };
+			table[static_cast<std::size_t>(TokenType::TILDE)] = { Prefix, UnaryOperatorType::COMPLEMENT };
+			table[static_cast<std::size_t>(TokenType::MINUS)] = { Prefix, UnaryOperatorType::NEGATE };
+			return table;
+		}
+
+		constexpr std::array<std::uint8_t, TokenTypeCount> buildPostfix() {
+			std::array<std::uint8_t, TokenTypeCount> table{};
+			table[static_cast<std::size_t>(TokenType::LEFT_PAREN)] = Postfix;
+			table[static_cast<std::size_t>(TokenType::LEFT_BRACKET)] = Postfix;
+			return table;
+		}
+
+		constexpr std::array<Infix, TokenTypeCount> InfixTable = buildInfix();
+		constexpr std::array<Unary, TokenTypeCount> PrefixTable = buildPrefix();
+		constexpr std::array<std::uint8_t, TokenTypeCount> PostfixTable = buildPostfix();
+
+		static_assert(Postfix > Prefix && Prefix > 2 * maxPriority() + 1, "Unary operators must bind tighter than binary ones");
+		static_assert(InfixTable[static_cast<std::size_t>(TokenType::STAR)].left > InfixTable[static_cast<std::size_t>(TokenType::PLUS)].right, "* binds tighter than +");
+		static_assert(InfixTable[static_cast<std::size_t>(TokenType::MINUS)].left < InfixTable[static_cast<std::size_t>(TokenType::MINUS)].right, "- is left-associative");
+		static_assert(InfixTable[static_cast<std::size_t>(TokenType::EQUAL)].left > InfixTable[static_cast<std::size_t>(TokenType::EQUAL)].right, "= is right-associative");
+		static_assert(InfixTable[static_cast<std::size_t>(TokenType::SEMICOLON)].left == None, "; ends an expression");
+
+		constexpr const Infix& infix(TokenType type) { return InfixTable[static_cast<std::size_t>(type)]; }
+		constexpr const Unary& prefix(TokenType type) { return PrefixTable[static_cast<std::size_t>(type)]; }
+		constexpr std::uint8_t postfix(TokenType type) { return PostfixTable[static_cast<std::size_t>(type)]; }
+	}
+}
@@ -0,0 +1,391 @@
+#include "FlatAST.hpp"
+
+#include "ASTVisitor.hpp"
+
+namespace ozToy::AST {
+
+	namespace {
+		// Appends each node in pre-order, so that its first child lands right after it
+		class Flattener : public TopLevelVisitor<Flattener, NodeIndex>, public ExpressionVisitor<Flattener, NodeIndex>
+		{
+			FlatTree& tree;
+			bool failed = false;
+		public:
+			using TopLevelVisitor<Flattener, NodeIndex>::visit;
+			using ExpressionVisitor<Flattener, NodeIndex>::visit;
+
+			Flattener(FlatTree& tree) : tree(tree) {}
+			// Whether a function body could not be parsed
+			bool hasFailed() const { return failed; }
+
+			NodeIndex visitModule(const Module* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::MODULE, node->getOffset());
+				const ArenaSpan<TopLevel*>& topLevel = node->getTopLevel();
+				std::uint32_t list = tree.addExtra(2 + topLevel.size);
+				tree.setExtra(list, tree.intern(node->getName()));
+				tree.setExtra(list + 1, static_cast<std::uint32_t>(topLevel.size));
+				for (std::size_t i = 0; i < topLevel.size; ++i)
+				{
+					tree.setExtra(list + 2 + static_cast<std::uint32_t>(i), visit(topLevel[i]));
+				}
+				tree.setOperand(self, list);
+				return self;
+			}
+
+			NodeIndex visitFunction(const DeclarationFunction* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::DECLARATION_FUNCTION, node->getOffset());
+				const ArenaSpan<Argument*>& arguments = node->getArguments();
+				std::uint32_t signature = tree.addExtra(4 + arguments.size);
+				tree.setExtra(signature, tree.intern(node->getName()));
+				tree.setExtra(signature + 1, tree.intern(node->getReturnType()));
+				tree.setExtra(signature + 3, static_cast<std::uint32_t>(arguments.size));
+				for (std::size_t i = 0; i < arguments.size; ++i)
+				{
+					tree.setExtra(signature + 4 + static_cast<std::uint32_t>(i), visitArgument(arguments[i]));
+				}
+				// A lazy body that does not parse; flatten() discards the tree
+				BlockExpression* body = node->getBody();
+				if (body == nullptr)
+					failed = true;
+				tree.setExtra(signature + 2, body != nullptr ? visit(body) : tree.addNode(NodeKind::NOP, node->getOffset()));
+				tree.setOperand(self, signature);
+				return self;
+			}
+
+			NodeIndex visitArgument(const Argument* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::ARGUMENT, node->getOffset());
+				std::uint32_t names = tree.addExtra(2);
+				tree.setExtra(names, tree.intern(node->getName()));
+				tree.setExtra(names + 1, tree.intern(node->getType()));
+				tree.setOperand(self, names);
+				return self;
+			}
+
+			NodeIndex visitDeclarationVariable(const DeclarationVariable* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::DECLARATION_VARIABLE, node->getOffset(), node->getIsMutable());
+				std::uint32_t names = tree.addExtra(2);
+				tree.setExtra(names, node->getName());
+				tree.setExtra(names + 1, node->getTypeIsInferred() ? FlatTree::NoSymbol : tree.intern(node->getType()));
+				tree.setOperand(self, names);
+				return self;
+			}
+
+			NodeIndex visitBlock(const BlockExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::BLOCK, node->getOffset());
+				visit(node->getInner());
+				return self;
+			}
+
+			NodeIndex visitSequence(const SequenceExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::SEQUENCE, node->getOffset());
+				const ArenaSpan<Expression*>& statements = node->getStatements();
+				std::uint32_t list = tree.addExtra(1 + statements.size);
+				tree.setExtra(list, static_cast<std::uint32_t>(statements.size));
+				for (std::size_t i = 0; i < statements.size; ++i)
+				{
+					tree.setExtra(list + 1 + static_cast<std::uint32_t>(i), visit(statements[i]));
+				}
+				tree.setOperand(self, list);
+				return self;
+			}
+
+			NodeIndex visitLiteral(NodeKind kind, const Node* node, std::string_view value)
+			{
+				NodeIndex self = tree.addNode(kind, node->getOffset());
+				tree.setOperand(self, tree.addLiteral(value));
+				return self;
+			}
+
+			NodeIndex visitNumber(const NumberExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::NUMBER, node->getOffset(), node->getIsFloat());
+				tree.setOperand(self, tree.addNumber(node->getValue()));
+				return self;
+			}
+
+			NodeIndex visitString(const StringExpression* node) { return visitLiteral(NodeKind::STRING, node, node->getValue()); }
+			NodeIndex visitChar(const CharExpression* node) { return visitLiteral(NodeKind::CHAR, node, node->getValue()); }
+
+			NodeIndex visitIdentifier(const IdentifierExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::IDENTIFIER, node->getOffset());
+				tree.setOperand(self, node->getValue());
+				return self;
+			}
+
+			NodeIndex visitBinary(const BinaryExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::BINARY, node->getOffset(), static_cast<std::uint8_t>(node->getType()));
+				visit(node->getLeft());
+				tree.setOperand(self, visit(node->getRight()));
+				return self;
+			}
+
+			NodeIndex visitUnary(const UnaryExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::UNARY, node->getOffset(), static_cast<std::uint8_t>(node->getType()));
+				visit(node->getOperand());
+				return self;
+			}
+
+			NodeIndex visitCall(const CallExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::CALL, node->getOffset());
+				visit(node->getCallee());
+				const ArenaSpan<Expression*>& arguments = node->getArguments();
+				std::uint32_t list = tree.addExtra(1 + arguments.size);
+				tree.setExtra(list, static_cast<std::uint32_t>(arguments.size));
+				for (std::size_t i = 0; i < arguments.size; ++i)
+				{
+					tree.setExtra(list + 1 + static_cast<std::uint32_t>(i), visit(arguments[i]));
+				}
+				tree.setOperand(self, list);
+				return self;
+			}
+
+			NodeIndex visitIndex(const IndexExpression* node)
+			{
+				NodeIndex self = tree.addNode(NodeKind::INDEX, node->getOffset());
+				visit(node->getTarget());
+				tree.setOperand(self, visit(node->getIndex()));
+				return self;
+			}
+
+			NodeIndex visitNop(const NOPExpression* node)
+			{
+				return tree.addNode(NodeKind::NOP, node->getOffset());
+			}
+		};
+	}
+
+	FlatTree::FlatTree(SymbolTable* symbols) : symbols(symbols)
+	{
+		literalStarts.push_back(0);
+	}
+
+	FlatTree* FlatTree::flatten(const Root* root, SymbolTable* symbols)
+	{
+		FlatTree* tree = new FlatTree(symbols);
+		Flattener flattener(*tree);
+		for (auto topLevel : root->getTopLevel())
+		{
+			tree->addTopLevel(flattener.visit(topLevel));
+		}
+		if (flattener.hasFailed())
+		{
+			delete tree;
+			return nullptr;
+		}
+		// The tree is read-only from here on, so drop the growth slack
+		tree->kinds.shrink_to_fit();
+		tree->tags.shrink_to_fit();
+		tree->offsets.shrink_to_fit();
+		tree->operands.shrink_to_fit();
+		tree->extra.shrink_to_fit();
+		tree->topLevel.shrink_to_fit();
+		tree->literalStarts.shrink_to_fit();
+		tree->literalChars.shrink_to_fit();
+		tree->numbers.shrink_to_fit();
+		return tree;
+	}
+
+	NodeIndex FlatTree::addNode(NodeKind kind, std::uint32_t offset, std::uint8_t tag)
+	{
+		NodeIndex node = static_cast<NodeIndex>(kinds.size());
+		kinds.push_back(kind);
+		tags.push_back(tag);
+		offsets.push_back(offset);
+		operands.push_back(0);
+		return node;
+	}
+
+	std::uint32_t FlatTree::addExtra(std::size_t count)
+	{
+		std::uint32_t index = static_cast<std::uint32_t>(extra.size());
+		extra.resize(extra.size() + count);
+		return index;
+	}
+
+	std::uint32_t FlatTree::addLiteral(std::string_view value)
+	{
+		std::uint32_t literal = static_cast<std::uint32_t>(literalStarts.size() - 1);
+		literalChars.append(value.data(), value.size());
+		literalStarts.push_back(static_cast<std::uint32_t>(literalChars.size()));
+		return literal;
+	}
+
+	std::uint32_t FlatTree::addNumber(std::uint64_t value)
+	{
+		numbers.push_back(value);
+		return static_cast<std::uint32_t>(numbers.size() - 1);
+	}
+
+	std::string_view FlatTree::getLiteral(std::uint32_t literal) const
+	{
+		return std::string_view(literalChars).substr(literalStarts[literal], literalStarts[literal + 1] - literalStarts[literal]);
+	}
+
+	std::size_t FlatTree::getMemoryUsage() const
+	{
+		return kinds.capacity() * sizeof(NodeKind)
+			+ tags.capacity() * sizeof(std::uint8_t)
+			+ (offsets.capacity() + operands.capacity() + extra.capacity() + literalStarts.capacity()) * sizeof(std::uint32_t)
+			+ topLevel.capacity() * sizeof(NodeIndex)
+			+ literalChars.capacity()
+			+ numbers.capacity() * sizeof(std::uint64_t);
+	}
+
+	void FlatTree::generateHIR(HIR::ModuleBuilder& mBuilder) const
+	{
+		for (NodeIndex node : topLevel)
+		{
+			lowerTopLevel(node, mBuilder);
+		}
+	}
+
+	void FlatTree::lowerTopLevel(NodeIndex node, HIR::ModuleBuilder& mBuilder) const
+	{
+		switch (kinds[node])
+		{
+		case NodeKind::MODULE:
+		{
+			std::uint32_t list = operands[node];
+			HIR::ModuleBuilder m(mBuilder.getModule().createModule(symbols->getName(extra[list])));
+			for (std::uint32_t i = 0; i < extra[list + 1]; ++i)
+			{
+				lowerTopLevel(extra[list + 2 + i], m);
+			}
+			break;
+		}
+		case NodeKind::DECLARATION_FUNCTION:
+		{
+			std::uint32_t signature = operands[node];
+			HIR::FunctionBuilder fBuilder(mBuilder.getModule().createFunction(symbols->getName(extra[signature])));
+			for (std::uint32_t i = 0; i < extra[signature + 3]; ++i)
+			{
+				std::uint32_t names = operands[extra[signature + 4 + i]];
+				fBuilder.addArgument(symbols->getName(extra[names]), symbols->getName(extra[names + 1]));
+			}
+			fBuilder.setReturnType(symbols->getName(extra[signature + 1]));
+			fBuilder.addInstruction(lowerExpression(extra[signature + 2], fBuilder));
+			break;
+		}
+		// Not top-level items
+		case NodeKind::ARGUMENT:
+		case NodeKind::DECLARATION_VARIABLE:
+		case NodeKind::BLOCK:
+		case NodeKind::SEQUENCE:
+		case NodeKind::NUMBER:
+		case NodeKind::STRING:
+		case NodeKind::CHAR:
+		case NodeKind::IDENTIFIER:
+		case NodeKind::BINARY:
+		case NodeKind::UNARY:
+		case NodeKind::CALL:
+		case NodeKind::INDEX:
+		case NodeKind::NOP:
+		case NodeKind::ROOT:
+			break;
+		}
+	}
+
+	HIR::Value* FlatTree::lowerExpression(NodeIndex node, HIR::FunctionBuilder& fBuilder) const
+	{
+		HIR::Value* value = nullptr;
+		switch (kinds[node])
+		{
+		case NodeKind::DECLARATION_VARIABLE:
+		{
+			std::uint32_t names = operands[node];
+			if (extra[names + 1] == NoSymbol)
+				value = fBuilder.declVariable(extra[names], false);
+			else
+				value = fBuilder.declVariable(extra[names], symbols->getName(extra[names + 1]), false);
+			break;
+		}
+		case NodeKind::BLOCK:
+			fBuilder.createBlock();
+			fBuilder.addInstruction(lowerExpression(node + 1, fBuilder));
+			value = fBuilder.exitBlock();
+			break;
+		case NodeKind::SEQUENCE:
+		{
+			std::uint32_t list = operands[node];
+			std::uint32_t count = extra[list];
+			for (std::uint32_t i = 0; i + 1 < count; ++i)
+			{
+				fBuilder.addInstruction(lowerExpression(extra[list + 1 + i], fBuilder));
+			}
+			return lowerExpression(extra[list + count], fBuilder);
+		}
+		// Shared constants, which take no offset
+		case NodeKind::NUMBER:
+			if (tags[node])
+				return fBuilder.getFloat(floatFromBits(numbers[operands[node]]));
+			return fBuilder.getInteger(numbers[operands[node]]);
+		case NodeKind::STRING:
+			return fBuilder.getString(getLiteral(operands[node]));
+		case NodeKind::CHAR:
+			return fBuilder.getChar(getLiteral(operands[node]));
+		case NodeKind::IDENTIFIER:
+			return fBuilder.getVariable(operands[node]);
+		case NodeKind::BINARY:
+		{
+			HIR::Value* left, *right;
+			if (evaluatesRightFirst(static_cast<BinaryOperatorType>(tags[node]))) {
+				right = lowerExpression(operands[node], fBuilder);
+				left = lowerExpression(node + 1, fBuilder);
+			}
+			else {
+				left = lowerExpression(node + 1, fBuilder);
+				right = lowerExpression(operands[node], fBuilder);
+			}
+			value = fBuilder.binaryOp(static_cast<BinaryOperatorType>(tags[node]), left, right);
+			break;
+		}
+		case NodeKind::UNARY:
+		{
+			HIR::Value* operand = lowerExpression(node + 1, fBuilder);
+			value = fBuilder.unaryOp(static_cast<UnaryOperatorType>(tags[node]), operand);
+			break;
+		}
+		case NodeKind::CALL:
+		{
+			HIR::Value* callee = lowerExpression(node + 1, fBuilder);
+			std::uint32_t list = operands[node];
+			std::uint32_t count = extra[list];
+			std::vector<HIR::Value*> arguments;
+			arguments.reserve(count);
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				arguments.push_back(lowerExpression(extra[list + 1 + i], fBuilder));
+			}
+			value = fBuilder.call(callee, arguments);
+			break;
+		}
+		case NodeKind::INDEX:
+		{
+			HIR::Value* target = lowerExpression(node + 1, fBuilder);
+			HIR::Value* index = lowerExpression(operands[node], fBuilder);
+			value = fBuilder.index(target, index);
+			break;
+		}
+		case NodeKind::NOP:
+			return HIR::UnitTypeValue::getInstance();
+		// Not expressions
+		case NodeKind::MODULE:
+		case NodeKind::DECLARATION_FUNCTION:
+		case NodeKind::ARGUMENT:
+		case NodeKind::ROOT:
+			OZTOY_UNREACHABLE();
+		}
+		value->setOffset(offsets[node]);
+		return value;
+	}
+}
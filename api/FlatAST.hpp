@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "HIRBuilder.hpp"
+#include "SymbolTable.hpp"
+
+namespace ozToy::AST {
+
+	class Root;
+
+	// Also the tag visitors dispatch on in the pointer AST, see Node::getKind
+	enum class NodeKind : std::uint8_t {
+		MODULE,
+		DECLARATION_FUNCTION,
+		ARGUMENT,
+		DECLARATION_VARIABLE,
+		BLOCK,
+		SEQUENCE,
+		NUMBER,
+		STRING,
+		CHAR,
+		IDENTIFIER,
+		BINARY,
+		UNARY,
+		CALL,
+		INDEX,
+		NOP,
+		// Only tags Root; never stored in a FlatTree
+		ROOT,
+	};
+
+	using NodeIndex = std::uint32_t;
+
+	// Read-only AST in parallel arrays, nodes in pre-order. Each node is a kind, a tag, an offset and one operand:
+	//   MODULE                extra index of { name symbol, count, children... }
+	//   DECLARATION_FUNCTION  extra index of { name symbol, return type symbol, body, count, arguments... }
+	//   ARGUMENT              extra index of { name symbol, type symbol }
+	//   DECLARATION_VARIABLE  extra index of { name symbol, type symbol or NoSymbol when inferred }; tag = isMutable
+	//   BLOCK                 - (inner is the first child)
+	//   SEQUENCE              extra index of { count, statements... }
+	//   NUMBER                number index; tag = isFloat
+	//   STRING, CHAR          literal index
+	//   IDENTIFIER            symbol
+	//   BINARY                right (left is the first child); tag = BinaryOperatorType
+	//   UNARY                 - (operand is the first child); tag = UnaryOperatorType
+	//   CALL                  extra index of { count, arguments... } (callee is the first child)
+	//   INDEX                 index (target is the first child)
+	//   NOP                   -
+	class FlatTree
+	{
+		std::vector<NodeKind> kinds;
+		std::vector<std::uint8_t> tags;
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> operands;
+		// Operands that do not fit in one slot: names, child lists and function signatures
+		std::vector<std::uint32_t> extra;
+		std::vector<NodeIndex> topLevel;
+		// Literal i is literalChars[literalStarts[i], literalStarts[i + 1])
+		std::vector<std::uint32_t> literalStarts;
+		std::string literalChars;
+		// Number values as the scanner parsed them, floats as the bits of their double
+		std::vector<std::uint64_t> numbers;
+		SymbolTable* symbols;
+
+		void lowerTopLevel(NodeIndex node, HIR::ModuleBuilder& mBuilder) const;
+		HIR::Value* lowerExpression(NodeIndex node, HIR::FunctionBuilder& fBuilder) const;
+	public:
+		static constexpr SymbolId NoSymbol = static_cast<SymbolId>(-1);
+
+		FlatTree(SymbolTable* symbols = SymbolTable::getInstance());
+		// Null when a lazy function body does not parse
+		static FlatTree* flatten(const Root* root, SymbolTable* symbols = SymbolTable::getInstance());
+
+		// Building, used by flatten()
+		NodeIndex addNode(NodeKind kind, std::uint32_t offset, std::uint8_t tag = 0);
+		void setOperand(NodeIndex node, std::uint32_t operand) { operands[node] = operand; }
+		// Reserves count extra slots and returns the index of the first
+		std::uint32_t addExtra(std::size_t count);
+		void setExtra(std::uint32_t index, std::uint32_t value) { extra[index] = value; }
+		std::uint32_t addLiteral(std::string_view value);
+		std::uint32_t addNumber(std::uint64_t value);
+		SymbolId intern(std::string_view name) { return symbols->intern(name); }
+		void addTopLevel(NodeIndex node) { topLevel.push_back(node); }
+
+		std::size_t size() const { return kinds.size(); }
+		NodeKind getKind(NodeIndex node) const { return kinds[node]; }
+		std::uint8_t getTag(NodeIndex node) const { return tags[node]; }
+		std::uint32_t getOffset(NodeIndex node) const { return offsets[node]; }
+		std::uint32_t getOperand(NodeIndex node) const { return operands[node]; }
+		NodeIndex getFirstChild(NodeIndex node) const { return node + 1; }
+		std::uint32_t getExtra(std::uint32_t index) const { return extra[index]; }
+		std::string_view getLiteral(std::uint32_t literal) const;
+		std::uint64_t getNumber(std::uint32_t number) const { return numbers[number]; }
+		const std::vector<NodeIndex>& getTopLevel() const { return topLevel; }
+		std::size_t getMemoryUsage() const;
+
+		// Same HIR as Root::generateHIR
+		void generateHIR(HIR::ModuleBuilder& mBuilder) const;
+	};
+}
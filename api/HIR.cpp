@@ -1,8 +1,13 @@
 #include "HIR.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
 namespace ozToy::HIR {
 
-	TranslationUnit::TranslationUnit()
+	TranslationUnit::TranslationUnit(SymbolTable* symbols) : types(this), symbols(symbols)
 	{
 		rootModule = new ModuleImpl("root", this);
 	}
@@ -17,10 +22,148 @@ namespace ozToy::HIR {
 		unresolvedNames.push_back(name);
 	}
 
+	void ScopedSymbolTable::enterBlock()
+	{
+		blockMarks.push_back(shadowed.size());
+	}
+
+	void ScopedSymbolTable::exitBlock()
+	{
+		std::size_t mark = blockMarks.back();
+		blockMarks.pop_back();
+		while (shadowed.size() > mark)
+		{
+			innermost[shadowed.back().id] = shadowed.back().previous;
+			shadowed.pop_back();
+		}
+	}
+
+	void ScopedSymbolTable::declare(SymbolId id, Variable* variable)
+	{
+		if (id >= innermost.size())
+			innermost.resize(static_cast<std::size_t>(id) + 1, nullptr);
+		shadowed.push_back({ id, innermost[id] });
+		innermost[id] = variable;
+	}
+
+	void TranslationUnit::addFunction(FunctionImpl* function)
+	{
+		functions.push_back(function);
+	}
+
+	namespace {
+		// What a name resolves to from one module, per SymbolId
+		struct ModuleLookupCache
+		{
+			struct Entry
+			{
+				const ModuleImpl* module = nullptr;
+				FunctionBase* target = nullptr;
+			};
+			std::vector<Entry> entries;
+		};
+
+		FunctionBase* findInModules(ModuleImpl* from, const std::string& name)
+		{
+			for (ModuleImpl* module = from; module != nullptr; module = module->getParent())
+			{
+				if (FunctionBase* target = module->findFunction(name))
+					return target;
+			}
+			return nullptr;
+		}
+
+		void resolveVariable(UnresolvedVariable* variable, ModuleLookupCache& cache)
+		{
+			const std::string& name = variable->getName();
+			FunctionImpl* function = variable->getFunction();
+			if (Argument* argument = function->findArgument(name))
+			{
+				variable->bind(argument);
+				return;
+			}
+
+			ModuleImpl* module = function->getParentModule();
+			SymbolId id = variable->getSymbol();
+			if (id >= cache.entries.size())
+				cache.entries.resize(static_cast<std::size_t>(id) + 1);
+			ModuleLookupCache::Entry& entry = cache.entries[id];
+			if (entry.module != module)
+			{
+				entry.module = module;
+				entry.target = findInModules(module, name);
+			}
+			if (entry.target != nullptr)
+				variable->bind(entry.target);
+		}
+
+		void resolveType(UnresolvedType* type)
+		{
+			const std::string& name = type->getName();
+			for (ModuleImpl* module = type->getScope(); module != nullptr; module = module->getParent())
+			{
+				if (StructBase* strct = module->findStruct(name))
+				{
+					type->bind(strct);
+					return;
+				}
+				if (ClassBase* clazz = module->findClass(name))
+				{
+					type->bind(clazz);
+					return;
+				}
+			}
+			if (PrimitiveType* primitive = PrimitiveType::lookup(name))
+				type->bind(primitive);
+		}
+	}
+
+	std::size_t TranslationUnit::resolveNames(std::size_t threadCount)
+	{
+		// Types are shared across functions, so they are resolved up front
+		for (auto type : types.getNamedTypes())
+		{
+			resolveType(type);
+		}
+
+		if (threadCount == 0)
+			threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		threadCount = std::min(threadCount, std::max<std::size_t>(1, functions.size()));
+
+		// Each worker takes whole functions; everything else is only read
+		std::atomic<std::size_t> nextFunction{ 0 };
+		auto work = [&]() {
+			ModuleLookupCache cache;
+			while (true)
+			{
+				std::size_t index = nextFunction.fetch_add(1, std::memory_order_relaxed);
+				if (index >= functions.size())
+					return;
+				for (auto variable : functions[index]->getUnresolvedVariables())
+					resolveVariable(variable, cache);
+			}
+		};
+		std::vector<std::thread> workers;
+		for (std::size_t i = 1; i < threadCount; ++i)
+			workers.emplace_back(work);
+		work();
+		for (auto& worker : workers)
+			worker.join();
+
+		std::size_t unresolved = 0;
+		for (auto name : unresolvedNames)
+		{
+			if (!name->isResolved())
+				++unresolved;
+		}
+		return unresolved;
+	}
+
 	void TranslationUnit::print(std::ostream& out)
 	{
 		for (auto&& name : unresolvedNames) {
-			out << name->getName() << std::endl;
+			if (!name->isResolved())
+				out << name->getName() << std::endl;
 		}
 	}
 
@@ -40,9 +183,50 @@ namespace ozToy::HIR {
 	{
 		FunctionImpl* function = new FunctionImpl(name, this, tu);
 		functions[name] = function;
+		tu->addFunction(function);
 		return function;
 	}
 
+	StructImpl* ModuleImpl::createStruct(std::string name)
+	{
+		StructImpl* strct = new StructImpl(name, this);
+		structs[name] = strct;
+		return strct;
+	}
+
+	ClassImpl* ModuleImpl::createClass(std::string name)
+	{
+		ClassImpl* clazz = new ClassImpl(name, this);
+		classes[name] = clazz;
+		return clazz;
+	}
+
+	StructImpl::StructImpl(std::string name, ModuleImpl* parentModule) : name(name), parentModule(parentModule)
+	{
+	}
+
+	ClassImpl::ClassImpl(std::string name, ModuleImpl* parentModule) : name(name), parentModule(parentModule)
+	{
+	}
+
+	FunctionBase* ModuleImpl::findFunction(const std::string& name) const
+	{
+		auto it = functions.find(name);
+		return it != functions.end() ? it->second : nullptr;
+	}
+
+	StructBase* ModuleImpl::findStruct(const std::string& name) const
+	{
+		auto it = structs.find(name);
+		return it != structs.end() ? it->second : nullptr;
+	}
+
+	ClassBase* ModuleImpl::findClass(const std::string& name) const
+	{
+		auto it = classes.find(name);
+		return it != classes.end() ? it->second : nullptr;
+	}
+
 	FunctionImpl::FunctionImpl(std::string name, ModuleImpl* parentModule, TranslationUnit* tu) : name(name), parentModule(parentModule), tu(tu)
 	{
 		rootBlock = new Block(new Scope(this));
@@ -60,25 +244,33 @@ namespace ozToy::HIR {
 
 	Type* FunctionImpl::getType(std::string name)
 	{
-		UnresolvedType* unresolved = new UnresolvedType(name);
-		tu->addUnresolvedName(unresolved);
-
-		return unresolved;
+		return tu->getTypes().getNamed(parentModule, name);
 	}
 
-	Variable* FunctionImpl::getVariableOutside(std::string name)
+	Variable* FunctionImpl::getVariableOutside(SymbolId name)
 	{
 		UnresolvedVariable* unresolved = new UnresolvedVariable(this, name);
 		tu->addUnresolvedName(unresolved);
+		unresolvedVariables.push_back(unresolved);
 		return unresolved;
 	}
 
+	Argument* FunctionImpl::findArgument(const std::string& name) const
+	{
+		for (auto argument : arguments)
+		{
+			if (argument->getName() == name)
+				return argument;
+		}
+		return nullptr;
+	}
+
 	Block* FunctionImpl::getRootBlock()
 	{
 		return rootBlock;
 	}
 
-	UnresolvedType::UnresolvedType(std::string name) : name(name)
+	UnresolvedType::UnresolvedType(std::string name, ModuleImpl* scope) : Type(TypeKind::NAMED), name(name), scope(scope)
 	{
 	}
 
@@ -87,6 +279,169 @@ namespace ozToy::HIR {
 		return name;
 	}
 
+	bool UnresolvedType::isResolved() const
+	{
+		return strct != nullptr || clazz != nullptr || primitive != nullptr;
+	}
+
+	PrimitiveType::PrimitiveType(std::string name) : Type(TypeKind::PRIMITIVE), name(name)
+	{
+	}
+
+	PrimitiveType* PrimitiveType::lookup(const std::string& name)
+	{
+		static PrimitiveType* primitives[] = {
+			new PrimitiveType("int"),
+			new PrimitiveType("float"),
+			new PrimitiveType("char"),
+			new PrimitiveType("string"),
+			new PrimitiveType("bool"),
+			new PrimitiveType("unit"),
+		};
+		for (auto primitive : primitives)
+		{
+			if (primitive->name == name)
+				return primitive;
+		}
+		return nullptr;
+	}
+
+	FunctionType::FunctionType(std::vector<Type*> parameters, Type* result) : Type(TypeKind::FUNCTION), parameters(parameters), result(result)
+	{
+	}
+
+	std::size_t TypeInterner::TypeListHash::operator()(const std::vector<Type*>& types) const
+	{
+		std::size_t hash = types.size();
+		for (Type* type : types)
+			hash = hash * 31 + std::hash<Type*>()(type);
+		return hash;
+	}
+
+	TypeInterner::TypeInterner(TranslationUnit* tu) : tu(tu)
+	{
+	}
+
+	ConstantPool::NumberTable::NumberTable() : slots(64, Slot{ 0, nullptr })
+	{
+	}
+
+	std::size_t ConstantPool::NumberTable::home(std::uint64_t key, std::size_t mask)
+	{
+		// Fibonacci hashing
+		return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+	}
+
+	Literal*& ConstantPool::NumberTable::find(std::uint64_t key)
+	{
+		if (2 * (count + 1) > slots.size())
+			grow();
+		std::size_t mask = slots.size() - 1;
+		std::size_t index = home(key, mask);
+		while (slots[index].literal != nullptr && slots[index].key != key)
+			index = (index + 1) & mask;
+		if (slots[index].literal == nullptr)
+		{
+			// Counted up front: the caller fills the slot in before the next lookup
+			slots[index].key = key;
+			++count;
+		}
+		return slots[index].literal;
+	}
+
+	void ConstantPool::NumberTable::grow()
+	{
+		std::vector<Slot> old(slots.size() * 2, Slot{ 0, nullptr });
+		old.swap(slots);
+		std::size_t mask = slots.size() - 1;
+		for (const Slot& slot : old)
+		{
+			if (slot.literal == nullptr)
+				continue;
+			std::size_t index = home(slot.key, mask);
+			while (slots[index].literal != nullptr)
+				index = (index + 1) & mask;
+			slots[index] = slot;
+		}
+	}
+
+	Literal* ConstantPool::getInteger(std::uint64_t value)
+	{
+		Literal*& literal = integers.find(value);
+		if (literal == nullptr)
+		{
+			literal = new Literal(static_cast<std::uint32_t>(literals.size()), LiteralType::INT, value, std::string());
+			literals.push_back(literal);
+		}
+		return literal;
+	}
+
+	Literal* ConstantPool::getFloat(double value)
+	{
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		Literal*& literal = floats.find(bits);
+		if (literal == nullptr)
+		{
+			literal = new Literal(static_cast<std::uint32_t>(literals.size()), LiteralType::FLOAT, bits, std::string());
+			literals.push_back(literal);
+		}
+		return literal;
+	}
+
+	Literal* ConstantPool::getString(std::string_view value)
+	{
+		auto it = strings.find(value);
+		if (it != strings.end())
+			return it->second;
+		Literal* literal = new Literal(static_cast<std::uint32_t>(literals.size()), LiteralType::STRING, 0, std::string(value));
+		literals.push_back(literal);
+		strings.emplace(literal->getText(), literal);
+		return literal;
+	}
+
+	Literal* ConstantPool::getChar(std::string_view value)
+	{
+		auto it = chars.find(value);
+		if (it != chars.end())
+			return it->second;
+		Literal* literal = new Literal(static_cast<std::uint32_t>(literals.size()), LiteralType::CHAR, 0, std::string(value));
+		literals.push_back(literal);
+		chars.emplace(literal->getText(), literal);
+		return literal;
+	}
+
+	std::size_t TypeInterner::NamedKeyHash::operator()(const NamedKey& key) const
+	{
+		return std::hash<const ModuleImpl*>()(key.scope) * 31 + key.name;
+	}
+
+	Type* TypeInterner::getNamed(ModuleImpl* scope, const std::string& name)
+	{
+		UnresolvedType*& type = namedByScope[{ scope, tu->getSymbols()->intern(name) }];
+		if (type == nullptr)
+		{
+			type = new UnresolvedType(name, scope);
+			named.push_back(type);
+			tu->addUnresolvedName(type);
+		}
+		return type;
+	}
+
+	Type* TypeInterner::getFunction(const std::vector<Type*>& parameters, Type* result)
+	{
+		std::vector<Type*> key;
+		key.reserve(parameters.size() + 1);
+		key.push_back(result);
+		key.insert(key.end(), parameters.begin(), parameters.end());
+		auto it = functions.find(key);
+		if (it != functions.end())
+			return it->second;
+		FunctionType* type = new FunctionType(parameters, result);
+		functions.emplace(std::move(key), type);
+		return type;
+	}
+
 	Scope::Scope(FunctionImpl* function) : function(function)
 	{
 		depth = 0;
@@ -109,27 +464,9 @@ namespace ozToy::HIR {
 		return parent;
 	}
 
-	void Scope::addVariable(std::string id, Variable* var)
+	void Scope::addVariable(Variable* var)
 	{
 		variables.push_back(var);
-		accessibleVariables[id] = var;
-	}
-
-	Value* Scope::getVariable(std::string id)
-	{
-		auto it = accessibleVariables.find(id);
-		if (it != accessibleVariables.end())
-		{
-			return it->second;
-		}
-		else if (parent != nullptr)
-		{
-			return parent->getVariable(id);
-		}
-		else
-		{
-			return function->getVariableOutside(id);
-		}
 	}
 
 	Scope::Scope(FunctionImpl* function, Scope* parent) : function(function), parent(parent)
@@ -141,40 +478,86 @@ namespace ozToy::HIR {
 	{
 	}
 
-	Variable* Argument::createVariable()
+	Variable* Argument::createVariable(SymbolTable* symbols)
 	{
-		return new Variable(name, type);
+		return new Variable(symbols->intern(name), type);
 	}
 
-	Value::Value(TypeConstraint* typeConstraint) : typeConstraint(typeConstraint)
+	Value::Value(ValueKind kind, Type* type, std::uint8_t tag) : type(type), kind(kind), tag(tag)
 	{
 	}
 
-	Variable::Variable(std::string name) : Value(new TypeConstraint()), name(name)
+	Variable::Variable(ValueKind kind, SymbolId name) : Value(kind), name(name)
 	{
 	}
 
-	Variable::Variable(std::string name, Type* type) : Value(new TypeConstraint(type)), name(name)
+	Variable::Variable(SymbolId name) : Value(ValueKind::VARIABLE), name(name)
 	{
 	}
 
-	UnresolvedVariable::UnresolvedVariable(FunctionImpl* function, std::string name) : Variable(name), function(function)
+	Variable::Variable(SymbolId name, Type* type) : Value(ValueKind::VARIABLE, type), name(name)
+	{
+	}
+
+	UnresolvedVariable::UnresolvedVariable(FunctionImpl* function, SymbolId name) : Variable(ValueKind::UNRESOLVED_VARIABLE, name), function(function)
 	{
 	}
 
 	const std::string& UnresolvedVariable::getName()
 	{
-		return name;
+		return function->getTranslationUnit()->getSymbols()->getName(name);
+	}
+
+	bool UnresolvedVariable::isResolved() const
+	{
+		return argument != nullptr || target != nullptr;
+	}
+
+	namespace {
+		PrimitiveType* getLiteralPrimitive(LiteralType type)
+		{
+			switch (type)
+			{
+			case LiteralType::STRING:
+				return PrimitiveType::lookup("string");
+			case LiteralType::CHAR:
+				return PrimitiveType::lookup("char");
+			case LiteralType::INT:
+				return PrimitiveType::lookup("int");
+			case LiteralType::FLOAT:
+				return PrimitiveType::lookup("float");
+			}
+			return nullptr;
+		}
+	}
+
+	Literal::Literal(std::uint32_t index, LiteralType type, std::uint64_t number, std::string text) : Value(ValueKind::LITERAL, getLiteralPrimitive(type), static_cast<std::uint8_t>(type)), index(index), number(number), text(std::move(text))
+	{
 	}
 
-	Literal::Literal(std::string value, LiteralType type) : Value(new TypeConstraint()), value(value), type(type)
+	double Literal::getFloat() const
 	{
+		double value;
+		std::memcpy(&value, &number, sizeof(value));
+		return value;
 	}
 	
-	Call::Call(Value* callee, std::vector<Value*> arguments) : Value(new TypeConstraint()), callee(callee), arguments(arguments)
+	Call::Call(Value* callee, std::vector<Value*> arguments) : Value(ValueKind::CALL), callee(callee), arguments(arguments)
 	{
 	}
-	Block::Block(Scope* linkedScope) : Value(new TypeConstraint()), linkedScope(linkedScope)
+	Assign::Assign(Value* target, Value* value) : Value(ValueKind::ASSIGN), target(target), value(value)
+	{
+	}
+
+	BinaryOp::BinaryOp(BinaryOperatorType op, Value* left, Value* right) : Value(ValueKind::BINARY_OP, nullptr, static_cast<std::uint8_t>(op)), left(left), right(right)
+	{
+	}
+
+	UnaryOp::UnaryOp(UnaryOperatorType op, Value* operand) : Value(ValueKind::UNARY_OP, nullptr, static_cast<std::uint8_t>(op)), operand(operand)
+	{
+	}
+
+	Block::Block(Scope* linkedScope) : Value(ValueKind::BLOCK), linkedScope(linkedScope)
 	{
 	}
 	void Block::addValue(Value* value)
@@ -185,20 +568,16 @@ namespace ozToy::HIR {
 	{
 		return linkedScope;
 	}
+	void Block::setScope(Scope* scope)
+	{
+		linkedScope = scope;
+	}
 	UnitTypeValue* UnitTypeValue::getInstance()
 	{
 		static UnitTypeValue* instance = new UnitTypeValue();
 		return instance;
 	}
-	TypeConstraint::TypeConstraint() : type(nullptr)
-	{
-	}
-
-	TypeConstraint::TypeConstraint(Type* type) : type(type)
-	{
-	}
-
-	UnitTypeValue::UnitTypeValue() : Value(new TypeConstraint())
+	UnitTypeValue::UnitTypeValue() : Value(ValueKind::UNIT)
 	{
 	}
 } // namespace ozToy::HIR
\ No newline at end of file
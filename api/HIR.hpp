@@ -5,6 +5,11 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <string_view>
+#include <unordered_map>
+
+#include "langdef.hpp"
+#include "SymbolTable.hpp"
 
 namespace ozToy::HIR{
 
@@ -28,6 +33,10 @@ namespace ozToy::HIR{
 
 	class Type;
 
+	class ScopedSymbolTable;
+	class Variable;
+	class Literal;
+
 	class UnresolvedName;
 	class UnresolvedClass;
 	class UnresolvedType;
@@ -36,27 +45,179 @@ namespace ozToy::HIR{
 	class UnresolvedName {
 	public:
 		virtual const std::string& getName() = 0;
+		// Whether TranslationUnit::resolveNames bound it
+		virtual bool isResolved() const = 0;
+	};
+
+	enum class TypeKind : std::uint8_t {
+		NAMED,
+		PRIMITIVE,
+		FUNCTION,
+		STRUCT,
+		CLASS,
 	};
 
 	class Type {
+		TypeKind kind;
+	protected:
+		explicit Type(TypeKind kind) : kind(kind) {}
+	public:
+		TypeKind getKind() const { return kind; }
+	};
+
+	// int, float, char, string, bool and unit
+	class PrimitiveType : public Type {
+		std::string name;
+		PrimitiveType(std::string name);
 	public:
-		Type() = default;
+		const std::string& getName() const { return name; }
+		// Null when name is not a primitive
+		static PrimitiveType* lookup(const std::string& name);
 	};
 
+	// A name as written in one module, resolved from that module outwards
 	class UnresolvedType : public UnresolvedName, public Type {
 		std::string name;
+		ModuleImpl* scope;
+		// Set by TranslationUnit::resolveNames, at most one of them
+		StructBase* strct = nullptr;
+		ClassBase* clazz = nullptr;
+		PrimitiveType* primitive = nullptr;
 	public:
-		UnresolvedType(std::string name);
+		UnresolvedType(std::string name, ModuleImpl* scope);
 		const std::string& getName() override;
+		ModuleImpl* getScope() const { return scope; }
+		bool isResolved() const override;
+		void bind(StructBase* strct) { this->strct = strct; }
+		void bind(ClassBase* clazz) { this->clazz = clazz; }
+		void bind(PrimitiveType* primitive) { this->primitive = primitive; }
+		StructBase* getStruct() const { return strct; }
+		ClassBase* getClass() const { return clazz; }
+		PrimitiveType* getPrimitive() const { return primitive; }
+	};
+
+	// fn (parameters) -> result
+	class FunctionType : public Type {
+		std::vector<Type*> parameters;
+		Type* result;
+	public:
+		FunctionType(std::vector<Type*> parameters, Type* result);
+		const std::vector<Type*>& getParameters() const { return parameters; }
+		Type* getResult() const { return result; }
+	};
+
+	// One object per distinct type, so types compare by pointer
+	class TypeInterner {
+		struct TypeListHash {
+			std::size_t operator()(const std::vector<Type*>& types) const;
+		};
+		struct NamedKey {
+			const ModuleImpl* scope;
+			SymbolId name;
+			bool operator==(const NamedKey& other) const { return scope == other.scope && name == other.name; }
+		};
+		struct NamedKeyHash {
+			std::size_t operator()(const NamedKey& key) const;
+		};
+		TranslationUnit* tu;
+		std::unordered_map<NamedKey, UnresolvedType*, NamedKeyHash> namedByScope;
+		// In the order they were first mentioned
+		std::vector<UnresolvedType*> named;
+		// Keyed by the result followed by the parameters
+		std::unordered_map<std::vector<Type*>, FunctionType*, TypeListHash> functions;
+	public:
+		TypeInterner(TranslationUnit* tu);
+		TypeInterner(const TypeInterner&) = delete;
+		TypeInterner& operator=(const TypeInterner&) = delete;
+		// name as written in scope
+		Type* getNamed(ModuleImpl* scope, const std::string& name);
+		const std::vector<UnresolvedType*>& getNamedTypes() const { return named; }
+		// The parameter and result types must already be canonical
+		Type* getFunction(const std::vector<Type*>& parameters, Type* result);
+	};
+
+	// Each distinct constant of a TranslationUnit, once; a Literal's index is its place in getLiterals()
+	class ConstantPool {
+		// Open addressing with the keys inline
+		class NumberTable {
+			struct Slot {
+				std::uint64_t key;
+				Literal* literal;
+			};
+			// Power-of-two size, at most half full
+			std::vector<Slot> slots;
+			std::size_t count = 0;
+			static std::size_t home(std::uint64_t key, std::size_t mask);
+			void grow();
+		public:
+			NumberTable();
+			// The slot's literal is null when key is new; the caller fills it in
+			Literal*& find(std::uint64_t key);
+		};
+		std::vector<Literal*> literals;
+		NumberTable integers;
+		// Keyed by the bits of the double, so 0.0 and -0.0 stay apart
+		NumberTable floats;
+		// Keyed by views of the Literals' own text
+		std::unordered_map<std::string_view, Literal*> strings;
+		std::unordered_map<std::string_view, Literal*> chars;
+	public:
+		ConstantPool() = default;
+		ConstantPool(const ConstantPool&) = delete;
+		ConstantPool& operator=(const ConstantPool&) = delete;
+		Literal* getInteger(std::uint64_t value);
+		Literal* getFloat(double value);
+		// Escapes already decoded
+		Literal* getString(std::string_view value);
+		Literal* getChar(std::string_view value);
+		const std::vector<Literal*>& getLiterals() const { return literals; }
+	};
+
+	// Name lookup for the function being built: innermost binding per SymbolId, plus what each declaration shadows
+	class ScopedSymbolTable {
+		struct Shadowed {
+			SymbolId id;
+			Variable* previous;
+		};
+		std::vector<Variable*> innermost;
+		std::vector<Shadowed> shadowed;
+		// Size of shadowed when each open block was entered
+		std::vector<std::size_t> blockMarks;
+	public:
+		void enterBlock();
+		void exitBlock();
+		void declare(SymbolId id, Variable* variable);
+		// Null when no open block declares id
+		Variable* lookup(SymbolId id) const
+		{
+			return id < innermost.size() ? innermost[id] : nullptr;
+		}
 	};
 
 	class TranslationUnit {
 		ModuleImpl* rootModule;
 		std::vector<UnresolvedName*> unresolvedNames;
+		// Every function of every module, in creation order
+		std::vector<FunctionImpl*> functions;
+		// Shared by the functions, which are built one at a time
+		ScopedSymbolTable scopes;
+		TypeInterner types;
+		ConstantPool constants;
+		// The table the source was lexed with
+		SymbolTable* symbols;
 	public:
-		TranslationUnit();
+		TranslationUnit(SymbolTable* symbols = SymbolTable::getInstance());
 		ModuleImpl* getRootModule();
+		SymbolTable* getSymbols() const { return symbols; }
+		ScopedSymbolTable& getScopes() { return scopes; }
+		TypeInterner& getTypes() { return types; }
+		ConstantPool& getConstants() { return constants; }
 		void addUnresolvedName(UnresolvedName* name);
+		void addFunction(FunctionImpl* function);
+		const std::vector<FunctionImpl*>& getFunctions() const { return functions; }
+		// Returns how many names are left; threadCount 0 means one per core
+		std::size_t resolveNames(std::size_t threadCount = 0);
+		// Lists the names that are still unresolved
 		void print(std::ostream& out);
 	};
 
@@ -64,6 +225,16 @@ namespace ozToy::HIR{
 
 	};
 
+	class StructBase : public Type {
+	protected:
+		StructBase() : Type(TypeKind::STRUCT) {}
+	};
+
+	class ClassBase : public Type {
+	protected:
+		ClassBase() : Type(TypeKind::CLASS) {}
+	};
+
 	class ModuleImpl : public ModuleBase {
 		TranslationUnit* tu;
 		std::string name;
@@ -76,18 +247,43 @@ namespace ozToy::HIR{
 		ModuleImpl(std::string name, TranslationUnit* tu);
 		ModuleImpl* createModule(std::string name);
 		FunctionImpl* createFunction(std::string name);
+		StructImpl* createStruct(std::string name);
+		ClassImpl* createClass(std::string name);
+		// Null for the root module
+		ModuleImpl* getParent() const { return parent; }
+		// Declared directly in this module; null when there is none
+		FunctionBase* findFunction(const std::string& name) const;
+		StructBase* findStruct(const std::string& name) const;
+		ClassBase* findClass(const std::string& name) const;
 	};
 
 	class ModuleRef : public ModuleBase {
 		ModuleImpl* impl;
 	};
 
+	class StructImpl : public StructBase {
+		std::string name;
+		ModuleImpl* parentModule;
+	public:
+		StructImpl(std::string name, ModuleImpl* parentModule);
+		const std::string& getName() const { return name; }
+		ModuleImpl* getParentModule() const { return parentModule; }
+	};
+
+	class ClassImpl : public ClassBase {
+		std::string name;
+		ModuleImpl* parentModule;
+	public:
+		ClassImpl(std::string name, ModuleImpl* parentModule);
+		const std::string& getName() const { return name; }
+		ModuleImpl* getParentModule() const { return parentModule; }
+	};
+
 	class FunctionBase {
 
 	};
 
 	class FunctionBody;
-	class TypeConstraint;
 	class Scope;
 	class Argument;
 	class Variable;
@@ -100,31 +296,39 @@ namespace ozToy::HIR{
 		std::string name;
 		std::vector<Argument*> arguments;
 		Block* rootBlock;
-		Type* returnType;
+		Type* returnType = nullptr;
+		std::vector<UnresolvedVariable*> unresolvedVariables;
 	public:
 		FunctionImpl(std::string name,ModuleImpl* parentModule, TranslationUnit* tu);
 		void setReturnType(Type* type);
+		// Null when no return type was given
+		Type* getReturnType() const { return returnType; }
 		void addArgument(Argument* arg);
+		const std::vector<Argument*>& getArguments() const { return arguments; }
 		Type* getType(std::string name);
-		Variable* getVariableOutside(std::string name);
+		Variable* getVariableOutside(SymbolId name);
 		Block* getRootBlock();
+		TranslationUnit* getTranslationUnit() { return tu; }
+		ModuleImpl* getParentModule() const { return parentModule; }
+		// Null when no argument has that name
+		Argument* findArgument(const std::string& name) const;
+		const std::vector<UnresolvedVariable*>& getUnresolvedVariables() const { return unresolvedVariables; }
 	};
 	
+	// The variables a block declares; only the root block and blocks that declare something have one
 	class Scope {
 		FunctionImpl* function;
 		std::size_t depth;
 		Scope* parent = nullptr;
 		std::vector<Scope*> children;
 		std::vector<Variable*> variables;
-		std::map<std::string, Variable*> accessibleVariables;
 		Scope(FunctionImpl* function, Scope* parent);
 	public:
 		Scope(FunctionImpl* function);
 		bool isRoot();
 		Scope* createChild();
 		Scope* getParent();
-		void addVariable(std::string id, Variable* var);
-		Value* getVariable(std::string id);
+		void addVariable(Variable* var);
 	};
 
 	class Argument {
@@ -132,42 +336,94 @@ namespace ozToy::HIR{
 		Type* type;
 	public:
 		Argument(std::string name, Type* type);
-		Variable* createVariable();
+		const std::string& getName() const { return name; }
+		Type* getType() const { return type; }
+		Variable* createVariable(SymbolTable* symbols);
 	};
 	
+	enum class ValueKind : std::uint8_t {
+		VARIABLE,
+		UNRESOLVED_VARIABLE,
+		LITERAL,
+		CALL,
+		ASSIGN,
+		BINARY_OP,
+		UNARY_OP,
+		BLOCK,
+		UNIT,
+	};
+
 	class Value {
-		TypeConstraint* typeConstraint;
+		// Declared or inferred; null while unknown
+		Type* type;
+		std::uint32_t offset = 0;
+		ValueKind kind;
+		std::uint8_t tag;
+	protected:
+		explicit Value(ValueKind kind, Type* type = nullptr, std::uint8_t tag = 0);
+		std::uint8_t getTag() const { return tag; }
 	public:
-		Value(TypeConstraint* typeConstraint);
+		ValueKind getKind() const { return kind; }
+		Type* getType() const { return type; }
+		void setType(Type* type) { this->type = type; }
+		std::uint32_t getOffset() const { return offset; }
+		void setOffset(std::uint32_t offset) { this->offset = offset; }
 	};
 
 	class Variable : public Value {
 	protected:
-		std::string name;
+		SymbolId name;
+		// TypeInference's index, while it works on the function
+		std::uint32_t typeVariable = NoTypeVariable;
+		Variable(ValueKind kind, SymbolId name);
 	public:
-		Variable(std::string name);
-		Variable(std::string name, Type* type);
+		static constexpr std::uint32_t NoTypeVariable = 0xFFFFFFFF;
+		Variable(SymbolId name);
+		Variable(SymbolId name, Type* type);
+		std::uint32_t getTypeVariable() const { return typeVariable; }
+		void setTypeVariable(std::uint32_t typeVariable) { this->typeVariable = typeVariable; }
 	};
 
+	// An argument of function, or a function it can see
 	class UnresolvedVariable : public Variable, public UnresolvedName {
 		FunctionImpl* function;
+		// Set by TranslationUnit::resolveNames, at most one of them
+		Argument* argument = nullptr;
+		FunctionBase* target = nullptr;
 	public:
-		UnresolvedVariable(FunctionImpl* function, std::string name);
+		UnresolvedVariable(FunctionImpl* function, SymbolId name);
 		const std::string& getName() override;
+		bool isResolved() const override;
+		FunctionImpl* getFunction() const { return function; }
+		SymbolId getSymbol() const { return name; }
+		void bind(Argument* argument) { this->argument = argument; }
+		void bind(FunctionBase* target) { this->target = target; }
+		Argument* getArgument() const { return argument; }
+		FunctionBase* getTarget() const { return target; }
 	};
 
-	enum class LiteralType {
+	enum class LiteralType : std::uint8_t {
 		STRING,
 		CHAR,
 		INT,
 		FLOAT,
 	};
 
+	// Shared by every use through the ConstantPool
 	class Literal : public Value {
-		std::string value;
-		LiteralType type;
+		// The tag is the LiteralType
+		std::uint32_t index;
+		// INT: the value; FLOAT: the bits of the double
+		std::uint64_t number;
+		// STRING and CHAR
+		std::string text;
 	public:
-		Literal(std::string value, LiteralType type);
+		Literal(std::uint32_t index, LiteralType type, std::uint64_t number, std::string text);
+		LiteralType getLiteralType() const { return static_cast<LiteralType>(getTag()); }
+		std::uint32_t getIndex() const { return index; }
+		std::uint64_t getInteger() const { return number; }
+		double getFloat() const;
+		const std::string& getText() const { return text; }
 	};
 
 	class Call : public Value {
@@ -175,15 +431,51 @@ namespace ozToy::HIR{
 		std::vector<Value*> arguments;
 	public:
 		Call(Value* callee, std::vector<Value*> arguments);
+		Value* getCallee() const { return callee; }
+		const std::vector<Value*>& getArguments() const { return arguments; }
+	};
+
+	// target = value and target := value
+	class Assign : public Value {
+		Value* target;
+		Value* value;
+	public:
+		Assign(Value* target, Value* value);
+		Value* getTarget() const { return target; }
+		Value* getValue() const { return value; }
+	};
+
+	// Every binary operator but = and :=
+	class BinaryOp : public Value {
+		// The tag is the BinaryOperatorType
+		Value* left;
+		Value* right;
+	public:
+		BinaryOp(BinaryOperatorType op, Value* left, Value* right);
+		BinaryOperatorType getOperator() const { return static_cast<BinaryOperatorType>(getTag()); }
+		Value* getLeft() const { return left; }
+		Value* getRight() const { return right; }
+	};
+
+	class UnaryOp : public Value {
+		// The tag is the UnaryOperatorType
+		Value* operand;
+	public:
+		UnaryOp(UnaryOperatorType op, Value* operand);
+		UnaryOperatorType getOperator() const { return static_cast<UnaryOperatorType>(getTag()); }
+		Value* getOperand() const { return operand; }
 	};
 
 	class Block : public Value {
 		Scope* linkedScope;
 		std::vector<Value*> values;
 	public:
-		Block(Scope* linkedScope);
+		Block(Scope* linkedScope = nullptr);
 		void addValue(Value* value);
+		const std::vector<Value*>& getValues() const { return values; }
+		// Null for a block that declares nothing
 		Scope* getScope();
+		void setScope(Scope* scope);
 	};
 
 	class UnitTypeValue : public Value {
@@ -191,11 +483,4 @@ namespace ozToy::HIR{
 	public:
 		static UnitTypeValue* getInstance();
 	};
-
-	class TypeConstraint {
-		Type* type = nullptr;
-	public:
-		TypeConstraint();
-		TypeConstraint(Type* type);
-	};
 } // namespace ozToy::HIR
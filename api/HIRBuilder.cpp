@@ -7,8 +7,25 @@ namespace ozToy::HIR {
 	{
 		return *module;
 	}
-	FunctionBuilder::FunctionBuilder(FunctionImpl* function) : function(function) {
-		blockStack.push(function->getRootBlock());
+	FunctionBuilder::FunctionBuilder(FunctionImpl* function) : function(function), scopes(function->getTranslationUnit()->getScopes()) {
+		Block* root = function->getRootBlock();
+		blockStack.push_back({ root, root->getScope() });
+		scopes.enterBlock();
+	}
+	FunctionBuilder::~FunctionBuilder()
+	{
+		while (!blockStack.empty())
+			exitBlock();
+	}
+	Scope* FunctionBuilder::declaringScope()
+	{
+		OpenBlock& open = blockStack.back();
+		if (open.block->getScope() == nullptr)
+		{
+			open.scope = open.scope->createChild();
+			open.block->setScope(open.scope);
+		}
+		return open.scope;
 	}
 
 	void FunctionBuilder::setReturnType(std::string type)
@@ -25,40 +42,77 @@ namespace ozToy::HIR {
 			function->addArgument(new Argument(arg.first, function->getType(arg.second)));
 		}
 	}
-	Value* FunctionBuilder::declVariable(std::string name, std::string type, bool isMutable)
+	Value* FunctionBuilder::declVariable(SymbolId name, std::string type, bool isMutable)
 	{
 		Variable* var = new Variable(name, function->getType(type));
-		Scope* scope = blockStack.top()->getScope();
-		scope->addVariable(name, var);
+		declaringScope()->addVariable(var);
+		scopes.declare(name, var);
 		return var;
 	}
-	Value* FunctionBuilder::declVariable(std::string name, bool isMutable)
+	Value* FunctionBuilder::declVariable(SymbolId name, bool isMutable)
 	{
 		Variable* var = new Variable(name);
-		Scope* scope = blockStack.top()->getScope();
-		scope->addVariable(name, var);
+		declaringScope()->addVariable(var);
+		scopes.declare(name, var);
 		return var;
 	}
-	Value* FunctionBuilder::getVariable(std::string name)
+	Value* FunctionBuilder::getVariable(SymbolId name)
+	{
+		Variable* var = scopes.lookup(name);
+		if (var != nullptr)
+			return var;
+		return function->getVariableOutside(name);
+	}
+	Value* FunctionBuilder::getInteger(std::uint64_t value)
+	{
+		return function->getTranslationUnit()->getConstants().getInteger(value);
+	}
+	Value* FunctionBuilder::getFloat(double value)
+	{
+		return function->getTranslationUnit()->getConstants().getFloat(value);
+	}
+	Value* FunctionBuilder::getString(std::string_view value)
+	{
+		return function->getTranslationUnit()->getConstants().getString(value);
+	}
+	Value* FunctionBuilder::getChar(std::string_view value)
+	{
+		return function->getTranslationUnit()->getConstants().getChar(value);
+	}
+	Value* FunctionBuilder::binaryOp(BinaryOperatorType type, Value* left, Value* right)
+	{
+		if (type == BinaryOperatorType::SUBSTITUTE || type == BinaryOperatorType::ASSIGN)
+			return new Assign(left, right);
+		return new BinaryOp(type, left, right);
+	}
+	Value* FunctionBuilder::unaryOp(UnaryOperatorType type, Value* operand)
+	{
+		return new UnaryOp(type, operand);
+	}
+	Value* FunctionBuilder::call(Value* callee, std::vector<Value*> arguments)
 	{
-		return blockStack.top()->getScope()->getVariable(name);
+		return new Call(callee, arguments);
 	}
-	Value* FunctionBuilder::getLiteral(std::string value, LiteralType type)
+	Value* FunctionBuilder::index(Value* target, Value* index)
 	{
-		return new Literal(value, type);
+		SymbolId indexSymbol = function->getTranslationUnit()->getSymbols()->intern("index");
+		return new Call(getVariable(indexSymbol), { target, index });
 	}
 	void FunctionBuilder::createBlock()
 	{
-		blockStack.push(new Block(blockStack.top()->getScope()->createChild()));
+		// The scope is created by the block's first declaration, if it has one
+		blockStack.push_back({ new Block(), blockStack.back().scope });
+		scopes.enterBlock();
 	}
 	void FunctionBuilder::addInstruction(Value* value)
 	{
-		blockStack.top()->addValue(value);
+		blockStack.back().block->addValue(value);
 	}
 	Value* FunctionBuilder::exitBlock()
 	{
-		Value* block = blockStack.top();
-		blockStack.pop();
+		Value* block = blockStack.back().block;
+		blockStack.pop_back();
+		scopes.exitBlock();
 		return block;
 	}
 } // namespace ozToy::HIR
\ No newline at end of file
@@ -1,5 +1,5 @@
 #pragma once
-#include <stack>
+#include <vector>
 
 #include "HIR.hpp"
 
@@ -26,17 +26,37 @@ namespace ozToy::HIR {
 	};
 
 	class FunctionBuilder {
+		struct OpenBlock {
+			Block* block;
+			// The block's own scope, or the nearest enclosing one until it declares something
+			Scope* scope;
+		};
 		FunctionImpl* function;
-		std::stack<Block*> blockStack;
+		ScopedSymbolTable& scopes;
+		std::vector<OpenBlock> blockStack;
+		Scope* declaringScope();
 	public:
 		FunctionBuilder(FunctionImpl* function);
+		FunctionBuilder(const FunctionBuilder&) = delete;
+		FunctionBuilder& operator=(const FunctionBuilder&) = delete;
+		// Leaves the blocks still open, so the unit's ScopedSymbolTable is empty again
+		~FunctionBuilder();
 		void setReturnType(std::string type);
 		void addArgument(std::string name, std::string type);
 		void addArguments(std::vector<std::pair<std::string, std::string>> args);
-		Value* declVariable(std::string name, std::string type, bool isMutable);
-		Value* declVariable(std::string name, bool isMutable);
-		Value* getVariable(std::string name);
-		Value* getLiteral(std::string value, LiteralType type);
+		Value* declVariable(SymbolId name, std::string type, bool isMutable);
+		Value* declVariable(SymbolId name, bool isMutable);
+		Value* getVariable(SymbolId name);
+		// From the unit's ConstantPool, so the same constant is the same Value
+		Value* getInteger(std::uint64_t value);
+		Value* getFloat(double value);
+		Value* getString(std::string_view value);
+		Value* getChar(std::string_view value);
+		// From already lowered operands
+		Value* binaryOp(BinaryOperatorType type, Value* left, Value* right);
+		Value* unaryOp(UnaryOperatorType type, Value* operand);
+		Value* call(Value* callee, std::vector<Value*> arguments);
+		Value* index(Value* target, Value* index);
 		void createBlock();
 		void addInstruction(Value* value);
 		Value* exitBlock();
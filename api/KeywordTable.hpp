@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "langdef.hpp"
+
+namespace ozToy {
+
+	struct Keyword
+	{
+		std::string_view spelling;
+		TokenType type;
+	};
+
+	constexpr Keyword Keywords[] = {
+#define OZTOY_KEYWORD_ENTRY(name, spelling) { spelling, TokenType::name },
+		OZTOY_KEYWORD_TOKENS(OZTOY_KEYWORD_ENTRY)
+#undef OZTOY_KEYWORD_ENTRY
+	};
+
+	// Perfect hash over Keywords, found at compile time
+	namespace KeywordHash {
+		constexpr std::size_t SlotBits = 6;
+		constexpr std::size_t SlotCount = std::size_t(1) << SlotBits;
+		constexpr std::uint8_t EmptySlot = 0xFF;
+		constexpr std::uint32_t NoSeed = 0;
+
+		static_assert(std::size(Keywords) < EmptySlot, "Too many keywords for an 8-bit slot table");
+		static_assert(std::size(Keywords) <= SlotCount / 2, "Keyword table is too dense, increase SlotBits");
+
+		constexpr std::uint32_t key(std::string_view text) {
+			std::uint32_t first = static_cast<unsigned char>(text[0]);
+			std::uint32_t second = static_cast<unsigned char>(text[text.size() > 1 ? 1 : 0]);
+			std::uint32_t last = static_cast<unsigned char>(text[text.size() - 1]);
+			return first | (second << 8) | (last << 16) | (static_cast<std::uint32_t>(text.size()) << 24);
+		}
+
+		constexpr std::size_t slot(std::uint32_t key, std::uint32_t seed) {
+			return static_cast<std::uint32_t>(key * seed) >> (32 - SlotBits);
+		}
+
+		constexpr bool isPerfect(std::uint32_t seed) {
+			std::uint64_t used = 0;
+			for (const Keyword& keyword : Keywords) {
+				std::uint64_t bit = std::uint64_t(1) << slot(key(keyword.spelling), seed);
+				if (used & bit)
+					return false;
+				used |= bit;
+			}
+			return true;
+		}
+
+		constexpr std::uint32_t findSeed() {
+			for (std::uint32_t i = 0; i < 1024; ++i) {
+				std::uint32_t seed = 0x9E3779B1u + i * 2;
+				if (isPerfect(seed))
+					return seed;
+			}
+			return NoSeed;
+		}
+
+		constexpr std::uint32_t Seed = findSeed();
+		static_assert(Seed != NoSeed, "No perfect hash seed found for the keyword table");
+
+		constexpr std::array<std::uint8_t, SlotCount> buildSlots() {
+			std::array<std::uint8_t, SlotCount> slots{};
+			for (std::size_t i = 0; i < SlotCount; ++i)
+				slots[i] = EmptySlot;
+			for (std::size_t i = 0; i < std::size(Keywords); ++i)
+				slots[slot(key(Keywords[i].spelling), Seed)] = static_cast<std::uint8_t>(i);
+			return slots;
+		}
+
+		constexpr std::array<std::uint8_t, SlotCount> Slots = buildSlots();
+
+		constexpr std::size_t maxLength() {
+			std::size_t length = 0;
+			for (const Keyword& keyword : Keywords)
+				length = keyword.spelling.size() > length ? keyword.spelling.size() : length;
+			return length;
+		}
+
+		constexpr std::size_t MaxLength = maxLength();
+	}
+
+	// IDENTIFIER if text is not a keyword
+	constexpr TokenType lookupKeyword(std::string_view text) {
+		if (text.empty() || text.size() > KeywordHash::MaxLength)
+			return TokenType::IDENTIFIER;
+		std::uint8_t index = KeywordHash::Slots[KeywordHash::slot(KeywordHash::key(text), KeywordHash::Seed)];
+		if (index != KeywordHash::EmptySlot && Keywords[index].spelling == text)
+			return Keywords[index].type;
+		return TokenType::IDENTIFIER;
+	}
+
+	static_assert(lookupKeyword("fn") == TokenType::FN, "Keyword lookup is broken");
+	static_assert(lookupKeyword("var") == TokenType::VAR, "Keyword lookup is broken");
+	static_assert(lookupKeyword("main") == TokenType::IDENTIFIER, "Keyword lookup is broken");
+}
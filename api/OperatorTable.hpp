@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "langdef.hpp"
+
+namespace ozToy {
+
+	struct Operator
+	{
+		std::string_view spelling;
+		TokenType type;
+	};
+
+	constexpr Operator Operators[] = {
+#define OZTOY_OPERATOR_ENTRY(name, spelling) { spelling, TokenType::name },
+		OZTOY_PUNCTUATOR_TOKENS(OZTOY_OPERATOR_ENTRY)
+#undef OZTOY_OPERATOR_ENTRY
+	};
+
+	// Longest-match DFA over Operators; state 0 is the start and also means no transition
+	namespace OperatorDfa {
+		constexpr std::uint8_t NoClass = 0;
+		constexpr std::uint8_t NoState = 0;
+
+		constexpr std::size_t stateBound() {
+			std::size_t states = 1;
+			for (const Operator& op : Operators)
+				states += op.spelling.size();
+			return states;
+		}
+
+		constexpr std::size_t StateBound = stateBound();
+		static_assert(StateBound < 256, "Too many operator states for an 8-bit transition table");
+
+		struct CharClasses {
+			std::array<std::uint8_t, 256> classOf{};
+			std::size_t count = 1;
+		};
+
+		constexpr CharClasses buildCharClasses() {
+			CharClasses classes;
+			for (const Operator& op : Operators) {
+				for (char c : op.spelling) {
+					std::uint8_t& cls = classes.classOf[static_cast<unsigned char>(c)];
+					if (cls == NoClass)
+						cls = static_cast<std::uint8_t>(classes.count++);
+				}
+			}
+			return classes;
+		}
+
+		constexpr CharClasses Classes = buildCharClasses();
+		constexpr std::size_t ClassCount = Classes.count;
+
+		struct Table {
+			std::array<std::array<std::uint8_t, ClassCount>, StateBound> next{};
+			std::array<TokenType, StateBound> accept{};
+			std::array<bool, StateBound> accepting{};
+			std::size_t stateCount = 1;
+		};
+
+		constexpr Table buildTable() {
+			Table table;
+			for (const Operator& op : Operators) {
+				std::size_t state = 0;
+				for (char c : op.spelling) {
+					std::uint8_t cls = Classes.classOf[static_cast<unsigned char>(c)];
+					if (table.next[state][cls] == NoState)
+						table.next[state][cls] = static_cast<std::uint8_t>(table.stateCount++);
+					state = table.next[state][cls];
+				}
+				table.accept[state] = op.type;
+				table.accepting[state] = true;
+			}
+			return table;
+		}
+
+		constexpr Table Transitions = buildTable();
+
+		constexpr bool everyStateAccepts() {
+			for (std::size_t state = 1; state < Transitions.stateCount; ++state) {
+				if (!Transitions.accepting[state])
+					return false;
+			}
+			return true;
+		}
+
+		static_assert(everyStateAccepts(), "Every operator prefix must itself be an operator, or the scanner would need to back up");
+
+		constexpr std::uint8_t classOf(char c) {
+			return Classes.classOf[static_cast<unsigned char>(c)];
+		}
+	}
+
+	// Returns the end of the longest operator at begin, or begin if there is none
+	constexpr const char* matchOperator(const char* begin, const char* end, TokenType& type) {
+		std::uint8_t state = OperatorDfa::NoState;
+		const char* cursor = begin;
+		while (cursor < end) {
+			std::uint8_t next = OperatorDfa::Transitions.next[state][OperatorDfa::classOf(*cursor)];
+			if (next == OperatorDfa::NoState)
+				break;
+			state = next;
+			++cursor;
+		}
+		if (state != OperatorDfa::NoState)
+			type = OperatorDfa::Transitions.accept[state];
+		return cursor;
+	}
+}
@@ -0,0 +1,342 @@
+#include "ScanKernels.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OZTOY_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define OZTOY_TARGET_SSE2 __attribute__((target("sse2")))
+#define OZTOY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OZTOY_TARGET_SSE2
+#define OZTOY_TARGET_AVX2
+#endif
+
+namespace ozToy {
+
+	namespace {
+		enum CharClass : std::uint8_t {
+			WHITESPACE = 1,
+			IDENTIFIER = 2,
+			DIGIT = 4,
+		};
+
+		struct CharClassTable {
+			std::uint8_t classes[256];
+			constexpr CharClassTable() : classes() {
+				classes[(unsigned char)' '] = WHITESPACE;
+				classes[(unsigned char)'\t'] = WHITESPACE;
+				classes[(unsigned char)'\n'] = WHITESPACE;
+				classes[(unsigned char)'\r'] = WHITESPACE;
+				for (int c = 'a'; c <= 'z'; ++c)
+					classes[c] = IDENTIFIER;
+				for (int c = 'A'; c <= 'Z'; ++c)
+					classes[c] = IDENTIFIER;
+				classes[(unsigned char)'_'] = IDENTIFIER;
+				for (int c = '0'; c <= '9'; ++c)
+					classes[c] = IDENTIFIER | DIGIT;
+			}
+		};
+
+		constexpr CharClassTable charClasses;
+
+		inline bool is(char c, std::uint8_t charClass) {
+			return (charClasses.classes[static_cast<unsigned char>(c)] & charClass) != 0;
+		}
+
+		const char* skipWhitespaceScalar(const char* begin, const char* end) {
+			while (begin < end && is(*begin, WHITESPACE))
+				++begin;
+			return begin;
+		}
+
+		const char* skipIdentifierScalar(const char* begin, const char* end) {
+			while (begin < end && is(*begin, IDENTIFIER))
+				++begin;
+			return begin;
+		}
+
+		const char* skipDigitsScalar(const char* begin, const char* end) {
+			while (begin < end && is(*begin, DIGIT))
+				++begin;
+			return begin;
+		}
+
+		const char* skipStringBodyScalar(const char* begin, const char* end, char quote) {
+			while (begin < end && *begin != quote && *begin != '\\')
+				++begin;
+			return begin;
+		}
+
+		void findLineStartsScalar(const char* begin, const char* end, std::uint32_t baseOffset, std::vector<std::uint32_t>& lineStarts) {
+			const char* cursor = begin;
+			while (cursor < end) {
+				const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+				if (newline == nullptr)
+					break;
+				cursor = newline + 1;
+				lineStarts.push_back(baseOffset + static_cast<std::uint32_t>(cursor - begin));
+			}
+		}
+
+		const ScanKernels scalarKernels = {
+			"scalar",
+			skipWhitespaceScalar,
+			skipIdentifierScalar,
+			skipDigitsScalar,
+			skipStringBodyScalar,
+			findLineStartsScalar,
+		};
+
+#ifdef OZTOY_SCAN_X86
+		inline unsigned countTrailingZeros(std::uint32_t mask) {
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+		}
+
+		// Byte-wise "lo <= c && c <= hi" for signed chars; bytes >= 0x80 never match.
+		OZTOY_TARGET_SSE2 inline __m128i inRange128(__m128i c, char lo, char hi) {
+			return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8(hi + 1)));
+		}
+
+		OZTOY_TARGET_SSE2 inline __m128i whitespace128(__m128i c) {
+			__m128i spaceOrTab = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t')));
+			__m128i newline = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\r')));
+			return _mm_or_si128(spaceOrTab, newline);
+		}
+
+		OZTOY_TARGET_SSE2 inline __m128i identifier128(__m128i c) {
+			__m128i letter = inRange128(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z');
+			__m128i digit = inRange128(c, '0', '9');
+			__m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+			return _mm_or_si128(_mm_or_si128(letter, digit), underscore);
+		}
+
+		OZTOY_TARGET_SSE2 const char* skipWhitespaceSse2(const char* begin, const char* end) {
+			while (end - begin >= 16) {
+				std::uint32_t mask = ~static_cast<std::uint32_t>(_mm_movemask_epi8(whitespace128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))))) & 0xFFFF;
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 16;
+			}
+			return skipWhitespaceScalar(begin, end);
+		}
+
+		OZTOY_TARGET_SSE2 const char* skipIdentifierSse2(const char* begin, const char* end) {
+			while (end - begin >= 16) {
+				std::uint32_t mask = ~static_cast<std::uint32_t>(_mm_movemask_epi8(identifier128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))))) & 0xFFFF;
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 16;
+			}
+			return skipIdentifierScalar(begin, end);
+		}
+
+		OZTOY_TARGET_SSE2 const char* skipDigitsSse2(const char* begin, const char* end) {
+			while (end - begin >= 16) {
+				std::uint32_t mask = ~static_cast<std::uint32_t>(_mm_movemask_epi8(inRange128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), '0', '9'))) & 0xFFFF;
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 16;
+			}
+			return skipDigitsScalar(begin, end);
+		}
+
+		OZTOY_TARGET_SSE2 const char* skipStringBodySse2(const char* begin, const char* end, char quote) {
+			__m128i quotes = _mm_set1_epi8(quote);
+			__m128i backslashes = _mm_set1_epi8('\\');
+			while (end - begin >= 16) {
+				__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+				std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(c, quotes), _mm_cmpeq_epi8(c, backslashes))));
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 16;
+			}
+			return skipStringBodyScalar(begin, end, quote);
+		}
+
+		// Walks every set bit of the mask
+		OZTOY_TARGET_SSE2 void findLineStartsSse2(const char* begin, const char* end, std::uint32_t baseOffset, std::vector<std::uint32_t>& lineStarts) {
+			__m128i newlines = _mm_set1_epi8('\n');
+			const char* cursor = begin;
+			while (end - cursor >= 16) {
+				std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cursor)), newlines)));
+				std::uint32_t lineBase = baseOffset + static_cast<std::uint32_t>(cursor - begin) + 1;
+				while (mask != 0) {
+					lineStarts.push_back(lineBase + countTrailingZeros(mask));
+					mask &= mask - 1;
+				}
+				cursor += 16;
+			}
+			findLineStartsScalar(cursor, end, baseOffset + static_cast<std::uint32_t>(cursor - begin), lineStarts);
+		}
+
+		const ScanKernels sse2Kernels = {
+			"sse2",
+			skipWhitespaceSse2,
+			skipIdentifierSse2,
+			skipDigitsSse2,
+			skipStringBodySse2,
+			findLineStartsSse2,
+		};
+
+		OZTOY_TARGET_AVX2 inline __m256i inRange256(__m256i c, char lo, char hi) {
+			return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+		}
+
+		OZTOY_TARGET_AVX2 inline __m256i whitespace256(__m256i c) {
+			__m256i spaceOrTab = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t')));
+			__m256i newline = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')));
+			return _mm256_or_si256(spaceOrTab, newline);
+		}
+
+		OZTOY_TARGET_AVX2 inline __m256i identifier256(__m256i c) {
+			__m256i letter = inRange256(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+			__m256i digit = inRange256(c, '0', '9');
+			__m256i underscore = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+			return _mm256_or_si256(_mm256_or_si256(letter, digit), underscore);
+		}
+
+		OZTOY_TARGET_AVX2 const char* skipWhitespaceAvx2(const char* begin, const char* end) {
+			while (end - begin >= 32) {
+				std::uint32_t mask = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(whitespace256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)))));
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 32;
+			}
+			return skipWhitespaceSse2(begin, end);
+		}
+
+		OZTOY_TARGET_AVX2 const char* skipIdentifierAvx2(const char* begin, const char* end) {
+			while (end - begin >= 32) {
+				std::uint32_t mask = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(identifier256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)))));
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 32;
+			}
+			return skipIdentifierSse2(begin, end);
+		}
+
+		OZTOY_TARGET_AVX2 const char* skipDigitsAvx2(const char* begin, const char* end) {
+			while (end - begin >= 32) {
+				std::uint32_t mask = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(inRange256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)), '0', '9')));
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 32;
+			}
+			return skipDigitsSse2(begin, end);
+		}
+
+		OZTOY_TARGET_AVX2 const char* skipStringBodyAvx2(const char* begin, const char* end, char quote) {
+			__m256i quotes = _mm256_set1_epi8(quote);
+			__m256i backslashes = _mm256_set1_epi8('\\');
+			while (end - begin >= 32) {
+				__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+				std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(c, quotes), _mm256_cmpeq_epi8(c, backslashes))));
+				if (mask != 0)
+					return begin + countTrailingZeros(mask);
+				begin += 32;
+			}
+			return skipStringBodySse2(begin, end, quote);
+		}
+
+		OZTOY_TARGET_AVX2 void findLineStartsAvx2(const char* begin, const char* end, std::uint32_t baseOffset, std::vector<std::uint32_t>& lineStarts) {
+			__m256i newlines = _mm256_set1_epi8('\n');
+			const char* cursor = begin;
+			while (end - cursor >= 32) {
+				std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cursor)), newlines)));
+				std::uint32_t lineBase = baseOffset + static_cast<std::uint32_t>(cursor - begin) + 1;
+				while (mask != 0) {
+					lineStarts.push_back(lineBase + countTrailingZeros(mask));
+					mask &= mask - 1;
+				}
+				cursor += 32;
+			}
+			findLineStartsSse2(cursor, end, baseOffset + static_cast<std::uint32_t>(cursor - begin), lineStarts);
+		}
+
+		const ScanKernels avx2Kernels = {
+			"avx2",
+			skipWhitespaceAvx2,
+			skipIdentifierAvx2,
+			skipDigitsAvx2,
+			skipStringBodyAvx2,
+			findLineStartsAvx2,
+		};
+
+		bool cpuHasSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+			return true;
+#elif defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			return (info[3] & (1 << 26)) != 0;
+#else
+			return __builtin_cpu_supports("sse2");
+#endif
+		}
+
+		bool cpuHasAvx2() {
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+			__cpuid(info, 1);
+			bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+			if (!osSavesYmm)
+				return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+#endif
+	}
+
+	const ScanKernels* getScalarScanKernels()
+	{
+		return &scalarKernels;
+	}
+
+	const ScanKernels* getSse2ScanKernels()
+	{
+#ifdef OZTOY_SCAN_X86
+		static const bool supported = cpuHasSse2();
+		return supported ? &sse2Kernels : nullptr;
+#else
+		return nullptr;
+#endif
+	}
+
+	const ScanKernels* getAvx2ScanKernels()
+	{
+#ifdef OZTOY_SCAN_X86
+		static const bool supported = cpuHasAvx2();
+		return supported ? &avx2Kernels : nullptr;
+#else
+		return nullptr;
+#endif
+	}
+
+	const ScanKernels* getScanKernels()
+	{
+		static const ScanKernels* selected = getAvx2ScanKernels() != nullptr ? getAvx2ScanKernels()
+			: getSse2ScanKernels() != nullptr ? getSse2ScanKernels()
+			: getScalarScanKernels();
+		return selected;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ozToy {
+
+	// Each kernel returns the first position in [begin, end) past the run, or end.
+	struct ScanKernels
+	{
+		const char* name;
+		const char* (*skipWhitespace)(const char* begin, const char* end);
+		const char* (*skipIdentifier)(const char* begin, const char* end);
+		const char* (*skipDigits)(const char* begin, const char* end);
+		// Stops at the closing quote or at a backslash, whichever comes first.
+		const char* (*skipStringBody)(const char* begin, const char* end, char quote);
+		// Appends the offset, plus baseOffset, of the byte after every '\n'
+		void (*findLineStarts)(const char* begin, const char* end, std::uint32_t baseOffset, std::vector<std::uint32_t>& lineStarts);
+	};
+
+	// Selected for the running CPU on first use
+	const ScanKernels* getScanKernels();
+
+	// Individual implementations, nullptr when the CPU does not support them.
+	const ScanKernels* getScalarScanKernels();
+	const ScanKernels* getSse2ScanKernels();
+	const ScanKernels* getAvx2ScanKernels();
+}
@@ -1,364 +1,259 @@
 #include "Scanner.hpp"
 
-ozToy::TokenType ozToy::Scanner::scanKeywordOrIdentifier(std::string& text)
+#include <charconv>
+
+#include "KeywordTable.hpp"
+#include "OperatorTable.hpp"
+#include "TokenPipe.hpp"
+#include "TokenStream.hpp"
+
+ozToy::TokenType ozToy::Scanner::scanKeywordOrIdentifier(std::string_view text)
 {
-	if (text == "fn") return TokenType::FN;
-	if (text == "let") return TokenType::LET;
-	if (text == "if") return TokenType::IF;
-	if (text == "then") return TokenType::THEN;
-	if (text == "else") return TokenType::ELSE;
-	if (text == "true") return TokenType::TRUE;
-	if (text == "false") return TokenType::FALSE;
-	if (text == "struct") return TokenType::STRUCT;
-	if (text == "class") return TokenType::CLASS;
-	if (text == "enum") return TokenType::ENUM;
-	if (text == "module") return TokenType::MODULE;
-	return TokenType::IDENTIFIER;
+	return lookupKeyword(text);
 }
 
-ozToy::Token ozToy::Scanner::scanIdentifier(char triggerChar)
+ozToy::Token ozToy::Scanner::scanIdentifier(const char* start)
 {
-	Token token{ TokenType::IDENTIFIER, std::string(1, triggerChar) };
-	while (true) {
-		char c = input->get();
-		if (('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || c == '_' || ('0' <= c && c <= '9')) {
-			token.text += c;
-		}
-		else {
-			input->unget();
-			break;
-		}
-	}
+	cursor = kernels->skipIdentifier(cursor, end);
+	Token token{ TokenType::IDENTIFIER, std::string_view(start, cursor - start) };
 	token.type = scanKeywordOrIdentifier(token.text);
+	if (token.type == TokenType::IDENTIFIER) {
+		token.symbol = symbols->intern(token.text);
+	}
 	return token;
 }
 
-ozToy::Token ozToy::Scanner::scanNumber(char triggerChar)
+namespace {
+	bool isDigit(char c)
+	{
+		return '0' <= c && c <= '9';
+	}
+
+	// 16 for anything that is not a hexadecimal digit
+	unsigned digitValue(char c)
+	{
+		if ('0' <= c && c <= '9')
+			return c - '0';
+		c |= 0x20;
+		if ('a' <= c && c <= 'f')
+			return c - 'a' + 10;
+		return 16;
+	}
+
+	bool isIdentifierChar(char c)
+	{
+		return isDigit(c) || ('a' <= (c | 0x20) && (c | 0x20) <= 'z') || c == '_';
+	}
+}
+
+ozToy::Token ozToy::Scanner::scanNumber(const char* start)
 {
-	Token token{ TokenType::NUMBER, std::string(1, triggerChar) };
-	while (true) {
-		char c = input->get();
-		if ('0' <= c && c <= '9') {
-			token.text += c;
+	std::uint64_t value = *start - '0';
+	while (cursor != end && isDigit(*cursor)) {
+		value = value * 10 + (*cursor - '0');
+		++cursor;
+	}
+	const char* digitsEnd = cursor;
+	bool isFloat = false;
+	char next = cursor != end ? *cursor : '\0';
+	if (next == '.' || isIdentifierChar(next)) {
+		if (digitsEnd - start == 1 && *start == '0' && ((next | 0x20) == 'x' || (next | 0x20) == 'b')) {
+			++cursor;
+			return scanPrefixedNumber(start, (next | 0x20) == 'x' ? 4 : 1);
 		}
-		else {
-			input->unget();
-			break;
+		// 1.foo is a member of 1, so a fraction needs a digit after the dot
+		if (end - cursor >= 2 && cursor[0] == '.' && isDigit(cursor[1])) {
+			cursor = kernels->skipDigits(cursor + 1, end);
+			isFloat = true;
+		}
+		if (cursor != end && (*cursor | 0x20) == 'e') {
+			const char* exponent = cursor + 1;
+			if (exponent != end && (*exponent == '+' || *exponent == '-'))
+				++exponent;
+			if (exponent != end && isDigit(*exponent)) {
+				cursor = kernels->skipDigits(exponent, end);
+				isFloat = true;
+			}
+		}
+		if (cursor != end && isIdentifierChar(*cursor)) {
+			return scanNumberError("Invalid suffix on numeric literal");
 		}
 	}
+
+	Token token{ isFloat ? TokenType::FLOAT : TokenType::NUMBER, std::string_view(start, cursor - start) };
+	if (isFloat) {
+		double real;
+		if (std::from_chars(start, cursor, real).ec != std::errc()) {
+			return Token{ TokenType::ERROR, "Float literal out of range" };
+		}
+		std::memcpy(&token.number, &real, sizeof(real));
+		return token;
+	}
+
+	// Up to 19 digits cannot overflow
+	if (digitsEnd - start > 19) {
+		const std::uint64_t Max = ~std::uint64_t(0);
+		value = 0;
+		for (const char* digit = start; digit != digitsEnd; ++digit) {
+			unsigned next = *digit - '0';
+			if (value > (Max - next) / 10) {
+				return Token{ TokenType::ERROR, "Integer literal out of range" };
+			}
+			value = value * 10 + next;
+		}
+	}
+	token.number = value;
+	return token;
+}
+
+// 0x and 0b literals; cursor is just past the x or b
+ozToy::Token ozToy::Scanner::scanPrefixedNumber(const char* start, unsigned bitsPerDigit)
+{
+	const unsigned radix = 1u << bitsPerDigit;
+	const char* digits = cursor;
+	std::uint64_t value = 0;
+	bool overflow = false;
+	while (cursor != end) {
+		unsigned digit = digitValue(*cursor);
+		if (digit >= radix)
+			break;
+		overflow |= (value >> (64 - bitsPerDigit)) != 0;
+		value = value << bitsPerDigit | digit;
+		++cursor;
+	}
+	if (cursor == digits) {
+		return scanNumberError(bitsPerDigit == 4 ? "Expected hexadecimal digits" : "Expected binary digits");
+	}
+	if (cursor != end && isIdentifierChar(*cursor)) {
+		return scanNumberError("Invalid suffix on numeric literal");
+	}
+	if (overflow) {
+		return Token{ TokenType::ERROR, "Integer literal out of range" };
+	}
+	Token token{ TokenType::NUMBER, std::string_view(start, cursor - start) };
+	token.number = value;
 	return token;
 }
 
+// Skips the rest of the malformed number
+ozToy::Token ozToy::Scanner::scanNumberError(const char* message)
+{
+	cursor = kernels->skipIdentifier(cursor, end);
+	return Token{ TokenType::ERROR, message };
+}
+
 ozToy::Token ozToy::Scanner::scanString(char triggerChar)
 {
-	Token token{ TokenType::STRING, std::string() };
+	const char* bodyStart = cursor;
 	while (true) {
-		char c = input->get();
-		if (c == '\\') {
-			c = input->get();
-			switch (c) {
-			case 'n':
-				token.text += '\n';
-				break;
-			case 'r':
-				token.text += '\r';
-				break;
-			case 't':
-				token.text += '\t';
-				break;
-			case '\\':
-				token.text += '\\';
-				break;
-			case '\'':
-				token.text += '\'';
-				break;
-			case '\"':
-				token.text += '\"';
-				break;
-			default:
-				token.text += c;
-				break;
-			}
+		cursor = kernels->skipStringBody(cursor, end, triggerChar);
+		if (cursor == end) {
+			return Token{ TokenType::ERROR, "Unterminated string literal" };
 		}
-		else if (c == triggerChar) {
+		char c = *cursor++;
+		if (c == triggerChar) {
 			break;
 		}
-		else {
-			token.text += c;
+		if (cursor == end) {
+			return Token{ TokenType::ERROR, "Unterminated string literal" };
 		}
+		++cursor; // Skip the escaped character
 	}
-	return token;
+	return Token{ TokenType::STRING, std::string_view(bodyStart, cursor - 1 - bodyStart) };
 }
 
 ozToy::Token ozToy::Scanner::scanChar(char triggerChar)
 {
-	char c = input->get();
-	if (c == '\\') {
-		c = input->get();
-		switch (c) {
-		case 'n':
-			c = '\n';
-			break;
-		case 'r':
-			c = '\r';
-			break;
-		case 't':
-			c = '\t';
-			break;
-		case '\\':
-			c = '\\';
-			break;
-		case '\'':
-			c = '\'';
-			break;
-		case '\"':
-			c = '\"';
-			break;
-		default:
-			break;
-		}
+	const char* bodyStart = cursor;
+	if (end - cursor < 2) {
+		return Token{ TokenType::ERROR, "Unterminated character literal" };
 	}
-	char c2 = input->get();
-	if (c2 != triggerChar) {
-		return Token{ TokenType::ERROR, "Expected " + std::string(1, triggerChar) };
+	if (*cursor++ == '\\') {
+		++cursor;
 	}
-	return Token{ TokenType::CHAR, std::string(1, c) };
+	if (cursor == end || *cursor != triggerChar) {
+		return Token{ TokenType::ERROR, "Expected '" };
+	}
+	++cursor;
+	return Token{ TokenType::CHAR, std::string_view(bodyStart, cursor - 1 - bodyStart) };
 }
 
 void ozToy::Scanner::scan()
 {
-	char c = input->get();
-	while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-		c = input->get();
+	if (pipe != nullptr) {
+		lastToken = pipe->next();
+		return;
+	}
+
+	if (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) {
+		++cursor;
+		cursor = kernels->skipWhitespace(cursor, end);
+	}
+	const char* start = cursor;
+	if (cursor == end) {
+		lastToken = Token{ TokenType::END_OF_FILE, std::string_view(end, 0) };
+		lastToken.offset = static_cast<std::uint32_t>(end - source->begin());
+		return;
 	}
+	char c = *cursor++;
 	if (('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || c == '_') {
-		lastToken = scanIdentifier(c);
+		lastToken = scanIdentifier(start);
 	}
 	else if ('0' <= c && c <= '9') {
-		lastToken = scanNumber(c);
+		lastToken = scanNumber(start);
+	}
+	else if (c == '"') {
+		lastToken = scanString(c);
+	}
+	else if (c == '\'') {
+		lastToken = scanChar(c);
 	}
 	else {
-		switch (c) {
-		case '+':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::PLUS_EQUAL, "+=" };
-			}
-			else if (c == '+') {
-				lastToken = Token{ TokenType::PLUS_PLUS, "++" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::PLUS, "+" };
-			}
-			break;
-		case '-':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::MINUS_EQUAL, "-=" };
-			}
-			else if (c == '-') {
-				lastToken = Token{ TokenType::MINUS_MINUS, "--" };
-			}
-			else if (c == '>') {
-				lastToken = Token{ TokenType::ARROW, "->" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::MINUS, "-" };
-			}
-			break;
-		case '*':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::STAR_EQUAL, "*=" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::STAR, "*" };
-			}
-			break;
-		case '/':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::SLASH_EQUAL, "/=" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::SLASH, "/" };
-			}
-			break;
-		case '%':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::PERCENT_EQUAL, "%=" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::PERCENT, "%" };
-			}
-			break;
-		case '=':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::EQUAL_EQUAL, "==" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::EQUAL, "=" };
-			}
-			break;
-		case '!':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::BANG_EQUAL, "!=" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::BANG, "!" };
-			}
-			break;
-		case '<':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::LESS_EQUAL, "<=" };
-			}
-			else if (c == '<') {
-				c = input->get();
-				if (c == '=') {
-					lastToken = Token{ TokenType::LESS_LESS_EQUAL, "<<=" };
-				}
-				else {
-					input->unget();
-					lastToken = Token{ TokenType::LESS_LESS, "<<" };
-				}
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::LESS, "<" };
-			}
-			break;
-		case '>':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::GREATER_EQUAL, ">=" };
-			}
-			else if (c == '>') {
-				c = input->get();
-				if (c == '=') {
-					lastToken = Token{ TokenType::GREATER_GREATER_EQUAL, ">>=" };
-				}
-				else {
-					input->unget();
-					lastToken = Token{ TokenType::GREATER_GREATER, ">>" };
-				}
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::GREATER, ">" };
-			}
-			break;
-		case '&':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::AMPERSAND_EQUAL, "&=" };
-			}
-			else if (c == '&') {
-				lastToken = Token{ TokenType::AMPERSAND_AMPERSAND, "&&" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::AMPERSAND, "&" };
-			}
-			break;
-		case '|':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::PIPE_EQUAL, "|=" };
-			}
-			else if (c == '|') {
-				lastToken = Token{ TokenType::PIPE_PIPE, "||" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::PIPE, "|" };
-			}
-			break;
-		case '^':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::CARET_EQUAL, "^=" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::CARET, "^" };
-			}
-			break;
-		case '~':
-			lastToken = Token{ TokenType::TILDE, "~" };
-			break;
-		case '?':
-			lastToken = Token{ TokenType::QUESTION, "?" };
-			break;
-		case ':':
-			c = input->get();
-			if (c == '=') {
-				lastToken = Token{ TokenType::ASSIGN, ":=" };
-			}
-			else {
-				input->unget();
-				lastToken = Token{ TokenType::COLON, ":" };
-			}
-			break;
-		case ';':
-			lastToken = Token{ TokenType::SEMICOLON, ";" };
-			break;
-		case ',':
-			lastToken = Token{ TokenType::COMMA, "," };
-			break;
-		case '.':
-			lastToken = Token{ TokenType::DOT, "." };
-			break;
-		case '(':
-			lastToken = Token{ TokenType::LEFT_PAREN, "(" };
-			break;
-		case ')':
-			lastToken = Token{ TokenType::RIGHT_PAREN, ")" };
-			break;
-		case '[':
-			lastToken = Token{ TokenType::LEFT_BRACKET, "[" };
-			break;
-		case ']':
-			lastToken = Token{ TokenType::RIGHT_BRACKET, "]" };
-			break;
-		case '{':
-			lastToken = Token{ TokenType::LEFT_BRACE, "{" };
-			break;
-		case '}':
-			lastToken = Token{ TokenType::RIGHT_BRACE, "}" };
-			break;
-		case '"':
-			lastToken = scanString(c);
-			break;
-		case '\'':
-			lastToken = scanChar(c);
-			break;
-		case EOF:
-			lastToken = Token{ TokenType::END_OF_FILE, "" };
-			break;
-		default:
-			lastToken = Token{ TokenType::OTHER, std::string(1, c) };
-			break;
+		TokenType type = TokenType::OTHER;
+		cursor = matchOperator(start, end, type);
+		if (cursor == start) {
+			++cursor;
 		}
+		lastToken = Token{ type, std::string_view(start, cursor - start) };
 	}
+	lastToken.offset = static_cast<std::uint32_t>(start - source->begin());
+}
+
+ozToy::Scanner::Scanner(std::istream* input) : Scanner(SourceBuffer::fromStream(input))
+{
+	ownsSource = true;
+}
+
+ozToy::Scanner::Scanner(SourceBuffer* source, SymbolTable* symbols) : source(source), ownsSource(false), symbols(symbols), kernels(getScanKernels()), cursor(source->begin()), end(source->end()), tokenUnget(false), stream(nullptr), index(0), pipe(nullptr)
+{
+}
+
+ozToy::Scanner::Scanner(TokenStream* stream) : Scanner(stream->getSource(), stream->getSymbolTable())
+{
+	this->stream = stream;
+}
+
+ozToy::Scanner::Scanner(TokenPipe* pipe) : Scanner(pipe->getSource(), pipe->getSymbolTable())
+{
+	this->pipe = pipe;
 }
 
-ozToy::Scanner::Scanner(std::istream* input) : input(input), tokenUnget(false)
+ozToy::Scanner::~Scanner()
 {
+	if (ownsSource)
+		delete source;
 }
 
-ozToy::Token ozToy::Scanner::getToken()
+const ozToy::Token& ozToy::Scanner::getToken()
 {
+	if (stream != nullptr)
+	{
+		lastToken = stream->get(index);
+		if (index < stream->size())
+			++index;
+		return lastToken;
+	}
+
 	if (tokenUnget)
 	{
 		tokenUnget = false;
@@ -370,8 +265,13 @@ ozToy::Token ozToy::Scanner::getToken()
 	return lastToken;
 }
 
-ozToy::Token ozToy::Scanner::peekToken()
+const ozToy::Token& ozToy::Scanner::peekToken()
 {
+	if (stream != nullptr) {
+		lastToken = stream->get(index);
+		return lastToken;
+	}
+
 	if (tokenUnget) {
 		return lastToken;
 	}
@@ -381,8 +281,29 @@ ozToy::Token ozToy::Scanner::peekToken()
 	return lastToken;
 }
 
-void ozToy::Scanner::putBackToken(Token token)
+const ozToy::Token& ozToy::Scanner::peekToken(std::size_t n)
+{
+	if (n == 0) {
+		return peekToken();
+	}
+
+	if (stream == nullptr) {
+		lastToken = Token{ TokenType::ERROR, "Lookahead past the next token needs a TokenStream" };
+		return lastToken;
+	}
+
+	lastToken = stream->get(index + n);
+	return lastToken;
+}
+
+void ozToy::Scanner::putBackToken(const Token& token)
 {
+	if (stream != nullptr) {
+		if (index > 0)
+			--index;
+		return;
+	}
+
 	if (tokenUnget) {
 		lastToken = Token{ TokenType::ERROR, "Cannot put back more than one token" };
 		return;
@@ -393,14 +314,27 @@ void ozToy::Scanner::putBackToken(Token token)
 
 void ozToy::Scanner::ungetToken()
 {
+	if (stream != nullptr) {
+		if (index > 0)
+			--index;
+		return;
+	}
+
 	if (tokenUnget) {
 		lastToken = Token{ TokenType::ERROR, "Cannot put back more than one token" };
 		return;
 	}
+	tokenUnget = true;
 }
 
 void ozToy::Scanner::consumeToken()
 {
+	if (stream != nullptr) {
+		if (index < stream->size())
+			++index;
+		return;
+	}
+
 	if (tokenUnget) {
 		tokenUnget = false;
 		return;
@@ -408,7 +342,65 @@ void ozToy::Scanner::consumeToken()
 	scan();
 }
 
-std::string ozToy::Token::toString()
+std::size_t ozToy::Scanner::mark() const
+{
+	if (stream != nullptr) {
+		return index;
+	}
+
+	if (tokenUnget) {
+		return lastToken.offset;
+	}
+	return static_cast<std::size_t>(cursor - source->begin());
+}
+
+void ozToy::Scanner::rewind(std::size_t mark)
 {
-	return "Token{ type: " + *TokenTypeToString(type) + ", value: " + text + " }";
+	if (stream != nullptr) {
+		index = mark;
+		return;
+	}
+
+	if (pipe != nullptr) {
+		lastToken = Token{ TokenType::ERROR, "Cannot rewind a pipelined scanner" };
+		tokenUnget = true;
+		return;
+	}
+
+	cursor = source->begin() + mark;
+	tokenUnget = false;
+}
+
+std::string ozToy::Token::toString() const
+{
+	return "Token{ type: " + std::string(TokenTypeToString(type)) + ", value: " + std::string(text) + " }";
+}
+
+std::string ozToy::decodeEscapes(std::string_view raw)
+{
+	std::string decoded;
+	decoded.reserve(raw.size());
+	for (std::size_t i = 0; i < raw.size(); ++i) {
+		char c = raw[i];
+		if (c != '\\' || i + 1 == raw.size()) {
+			decoded += c;
+			continue;
+		}
+		c = raw[++i];
+		switch (c) {
+		case 'n':
+			decoded += '\n';
+			break;
+		case 'r':
+			decoded += '\r';
+			break;
+		case 't':
+			decoded += '\t';
+			break;
+		default:
+			decoded += c;
+			break;
+		}
+	}
+	return decoded;
 }
@@ -1,110 +1,113 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 #include "langdef.hpp"
+#include "ScanKernels.hpp"
+#include "SourceBuffer.hpp"
+#include "SymbolTable.hpp"
 
 namespace ozToy {
 
-	const std::string TokenTypeNames[] = {
-		"END_OF_FILE",
-		"IDENTIFIER",
-		"NUMBER",
-		"STRING",
-		"CHAR",
-		"LEFT_PAREN",
-		"RIGHT_PAREN",
-		"LEFT_BRACE",
-		"RIGHT_BRACE",
-		"LEFT_BRACKET",
-		"RIGHT_BRACKET",
-		"COMMA",
-		"DOT",
-		"SEMICOLON",
-		"PLUS",
-		"MINUS",
-		"STAR",
-		"SLASH",
-		"PERCENT",
-		"CARET",
-		"AMPERSAND",
-		"PIPE",
-		"AMPERSAND_AMPERSAND",
-		"PIPE_PIPE",
-		"TILDE",
-		"BANG",
-		"QUESTION",
-		"COLON",
-		"EQUAL",
-		"LESS",
-		"GREATER",
-		"PLUS_EQUAL",
-		"MINUS_EQUAL",
-		"STAR_EQUAL",
-		"SLASH_EQUAL",
-		"PERCENT_EQUAL",
-		"AMPERSAND_EQUAL",
-		"PIPE_EQUAL",
-		"CARET_EQUAL",
-		"ASSIGN",
-		"PLUS_PLUS",
-		"MINUS_MINUS",
-		"LESS_LESS",
-		"GREATER_GREATER",
-		"LESS_EQUAL",
-		"GREATER_EQUAL",
-		"LESS_LESS_EQUAL",
-		"GREATER_GREATER_EQUAL",
-		"EQUAL_EQUAL",
-		"BANG_EQUAL",
-		"ARROW",
-		"LET",
-		"VAR",
-		"CLASS",
-		"STRUCT",
-		"ENUM",
-		"MODULE",
-		"FN",
-		"IF",
-		"THEN",
-		"ELSE",
-		"TRUE",
-		"FALSE",
-		"OTHER",
-		"ERROR",
+	constexpr std::string_view TokenTypeNames[] = {
+#define OZTOY_TOKEN_NAME(name) #name,
+#define OZTOY_SPELLED_TOKEN_NAME(name, spelling) #name,
+		OZTOY_LITERAL_TOKENS(OZTOY_TOKEN_NAME)
+		OZTOY_PUNCTUATOR_TOKENS(OZTOY_SPELLED_TOKEN_NAME)
+		OZTOY_KEYWORD_TOKENS(OZTOY_SPELLED_TOKEN_NAME)
+		OZTOY_SPECIAL_TOKENS(OZTOY_TOKEN_NAME)
+#undef OZTOY_SPELLED_TOKEN_NAME
+#undef OZTOY_TOKEN_NAME
 	};
 
-	inline std::string* TokenTypeToString(TokenType type) {
-		return (std::string*)&TokenTypeNames[(int)type];
+	inline std::string_view TokenTypeToString(TokenType type) {
+		return TokenTypeNames[(int)type];
 	}
 
+	// FLOAT tokens and the trees built from them keep a double as its bit pattern
+	inline double floatFromBits(std::uint64_t bits)
+	{
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// text is the raw body for STRING and CHAR; number is a NUMBER's value or a FLOAT's bits
 	struct Token
 	{
 		TokenType type;
-		std::string text;
-		std::string toString();
+		std::uint32_t offset;
+		std::string_view text;
+		union {
+			SymbolId symbol;
+			std::uint64_t number;
+		};
+		Token() : type(TokenType::END_OF_FILE), offset(0), number(0) {}
+		Token(TokenType type, std::string_view text, SymbolId symbol = 0, std::uint32_t offset = 0) : type(type), offset(offset), text(text), number(0)
+		{
+			this->symbol = symbol;
+		}
+		std::string toString() const;
 	};
 
+	class TokenStream;
+	class TokenPipe;
+
+	std::string decodeEscapes(std::string_view raw);
+
 	class Scanner
 	{
-		std::istream* input;
+		SourceBuffer* source;
+		bool ownsSource;
+		SymbolTable* symbols;
+		const ScanKernels* kernels;
+		const char* cursor;
+		const char* end;
 		Token lastToken;
 		bool tokenUnget;
+		// Pre-lexed mode: tokens come from stream[index] instead of the source
+		TokenStream* stream;
+		std::size_t index;
+		// Pipelined mode: tokens come from a TokenPipe fed by another thread
+		TokenPipe* pipe;
 
-		TokenType scanKeywordOrIdentifier(std::string& text);
-		Token scanIdentifier(char triggerChar);
-		Token scanNumber(char triggerChar);
+		TokenType scanKeywordOrIdentifier(std::string_view text);
+		Token scanIdentifier(const char* start);
+		Token scanNumber(const char* start);
+		Token scanPrefixedNumber(const char* start, unsigned bitsPerDigit);
+		Token scanNumberError(const char* message);
 		Token scanString(char triggerChar);
 		Token scanChar(char triggerChar);
 		void scan();
 	public:
 		Scanner(std::istream* input);
-		Token getToken();
-		Token peekToken();
-		void putBackToken(Token token);
+		Scanner(SourceBuffer* source, SymbolTable* symbols = SymbolTable::getInstance());
+		Scanner(TokenStream* stream);
+		Scanner(TokenPipe* pipe);
+		Scanner(const Scanner&) = delete;
+		Scanner& operator=(const Scanner&) = delete;
+		~Scanner();
+		const Token& getToken();
+		const Token& peekToken();
+		// Needs a TokenStream unless n == 0
+		const Token& peekToken(std::size_t n);
+		void putBackToken(const Token& token);
 		void ungetToken();
 		void consumeToken();
+		// rewind(mark()) makes the marked token the next one again; not with a TokenPipe
+		std::size_t mark() const;
+		void rewind(std::size_t mark);
+		SourceBuffer* getSource() const { return source; }
+		SymbolTable* getSymbols() const { return symbols; }
+		// The pre-lexed stream tokens come from, or null
+		TokenStream* getStream() const { return stream; }
+		// Whether a producer thread may still be interning into getSymbols()
+		bool isPiped() const { return pipe != nullptr; }
+		SourceLocation getLocation(const Token& token) const { return source->getLocation(token.offset); }
 	};
 }
 
@@ -0,0 +1,198 @@
+#include "SourceBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ScanKernels.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ozToy {
+
+	SourceBuffer::SourceBuffer(const char* data, std::size_t size, char* ownedData, void* mapping)
+		: data(data), size(size), ownedData(ownedData), mapping(mapping)
+	{
+	}
+
+	SourceBuffer::~SourceBuffer()
+	{
+		if (mapping != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle(static_cast<HANDLE>(mapping));
+#else
+			munmap(mapping, size);
+#endif
+		}
+		delete[] ownedData;
+	}
+
+	std::ostream& operator<<(std::ostream& out, const SourceLocation& location)
+	{
+		return out << location.line << ':' << location.column;
+	}
+
+	SourceLocation SourceBuffer::getLocation(std::uint32_t offset) const
+	{
+		std::call_once(lineStartsBuilt, [this]() {
+			lineStarts.push_back(0);
+			getScanKernels()->findLineStarts(data, data + size, 0, lineStarts);
+		});
+		// lineStarts[0] == 0, so upper_bound never returns begin()
+		auto next = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+		std::uint32_t line = static_cast<std::uint32_t>(next - lineStarts.begin());
+		return { line, offset - *(next - 1) + 1 };
+	}
+
+	SourceBuffer* SourceBuffer::fromString(const std::string& text)
+	{
+		char* owned = new char[text.size() + 1];
+		std::memcpy(owned, text.data(), text.size());
+		owned[text.size()] = '\0';
+		return new SourceBuffer(owned, text.size(), owned, nullptr);
+	}
+
+	SourceBuffer* SourceBuffer::fromFile(const std::string& path, std::ostream& errorOut)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			errorOut << "Cannot open " << path << std::endl;
+			return nullptr;
+		}
+
+		if (GetFileType(file) != FILE_TYPE_DISK)
+		{
+			// Pipes and character devices cannot be mapped
+			std::string text;
+			char chunk[1 << 16];
+			DWORD read = 0;
+			while (ReadFile(file, chunk, sizeof(chunk), &read, nullptr) && read != 0)
+				text.append(chunk, read);
+			CloseHandle(file);
+			return fromString(text);
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			errorOut << "Cannot get size of " << path << std::endl;
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		if (static_cast<unsigned long long>(fileSize.QuadPart) > MaxSize)
+		{
+			errorOut << path << " is larger than 4 GiB" << std::endl;
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		if (fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return new SourceBuffer("", 0, nullptr, nullptr);
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr)
+		{
+			errorOut << "Cannot map " << path << std::endl;
+			return nullptr;
+		}
+
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			errorOut << "Cannot map " << path << std::endl;
+			CloseHandle(mapping);
+			return nullptr;
+		}
+
+		return new SourceBuffer(static_cast<const char*>(view), static_cast<std::size_t>(fileSize.QuadPart), nullptr, mapping);
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			errorOut << "Cannot open " << path << std::endl;
+			return nullptr;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			errorOut << "Cannot get size of " << path << std::endl;
+			close(fd);
+			return nullptr;
+		}
+
+		if (!S_ISREG(st.st_mode))
+		{
+			// Pipes and character devices cannot be mapped
+			std::string text;
+			char chunk[1 << 16];
+			ssize_t n;
+			while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+				text.append(chunk, static_cast<std::size_t>(n));
+			close(fd);
+			return fromString(text);
+		}
+
+		std::size_t size = static_cast<std::size_t>(st.st_size);
+		if (size > MaxSize)
+		{
+			errorOut << path << " is larger than 4 GiB" << std::endl;
+			close(fd);
+			return nullptr;
+		}
+
+		if (size == 0)
+		{
+			close(fd);
+			return new SourceBuffer("", 0, nullptr, nullptr);
+		}
+
+		void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED)
+		{
+			errorOut << "Cannot map " << path << std::endl;
+			return nullptr;
+		}
+		madvise(view, size, MADV_SEQUENTIAL);
+
+		return new SourceBuffer(static_cast<const char*>(view), size, nullptr, view);
+#endif
+	}
+
+	SourceBuffer* SourceBuffer::fromStream(std::istream* input)
+	{
+		std::string text;
+		char chunk[1 << 16];
+		while (input->read(chunk, sizeof(chunk)) || input->gcount() > 0)
+			text.append(chunk, static_cast<std::size_t>(input->gcount()));
+		return fromString(text);
+	}
+
+	SourceBuffer* SourceBuffer::applyEdit(const SourceEdit& edit) const
+	{
+		std::string text;
+		text.reserve(size - edit.removedLength + edit.insertedText.size());
+		text.append(data, edit.offset);
+		text.append(edit.insertedText);
+		text.append(data + edit.offset + edit.removedLength, size - edit.offset - edit.removedLength);
+		return fromString(text);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ozToy {
+
+	// Replaces removedLength bytes at offset with insertedText.
+	struct SourceEdit
+	{
+		std::size_t offset;
+		std::size_t removedLength;
+		std::string_view insertedText;
+	};
+
+	// 1-based line and byte column of a source offset.
+	struct SourceLocation
+	{
+		std::uint32_t line;
+		std::uint32_t column;
+	};
+
+	std::ostream& operator<<(std::ostream& out, const SourceLocation& location);
+
+	// Whole source file in one block; regular files are memory-mapped, up to MaxSize bytes.
+	class SourceBuffer
+	{
+		const char* data;
+		std::size_t size;
+		char* ownedData;
+		void* mapping;
+		// Offset of the first byte of every line, built on the first getLocation call
+		mutable std::once_flag lineStartsBuilt;
+		mutable std::vector<std::uint32_t> lineStarts;
+		SourceBuffer(const char* data, std::size_t size, char* ownedData, void* mapping);
+	public:
+		static constexpr std::size_t MaxSize = 0xFFFFFFFFu;
+		SourceBuffer(const SourceBuffer&) = delete;
+		SourceBuffer& operator=(const SourceBuffer&) = delete;
+		~SourceBuffer();
+		const char* begin() const { return data; }
+		const char* end() const { return data + size; }
+		std::size_t getSize() const { return size; }
+		// Thread-safe
+		SourceLocation getLocation(std::uint32_t offset) const;
+		SourceBuffer* applyEdit(const SourceEdit& edit) const;
+		static SourceBuffer* fromFile(const std::string& path, std::ostream& errorOut = std::cerr);
+		static SourceBuffer* fromStream(std::istream* input);
+		static SourceBuffer* fromString(const std::string& text);
+	};
+}
@@ -0,0 +1,209 @@
+#include "StructuralHash.hpp"
+
+#include <cstring>
+
+#include "ASTVisitor.hpp"
+
+namespace ozToy {
+
+	namespace {
+		constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+		constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+		constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+		constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+
+		std::uint64_t rotateLeft(std::uint64_t value, int bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		std::uint64_t avalanche(std::uint64_t value)
+		{
+			value ^= value >> 33;
+			value *= 0xFF51AFD7ED558CCDull;
+			value ^= value >> 33;
+			value *= 0xC4CEB9FE1A85EC53ull;
+			value ^= value >> 33;
+			return value;
+		}
+
+		// Independent of the host's byte order
+		std::uint64_t loadLittleEndian(const char* bytes)
+		{
+			std::uint64_t word = 0;
+			for (int i = 0; i < 8; ++i)
+				word |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+			return word;
+		}
+	}
+
+	Hasher::Hasher() : low(Prime1), high(Prime3), length(0)
+	{
+	}
+
+	void Hasher::add(std::uint64_t value)
+	{
+		++length;
+		low = rotateLeft(low ^ (value * Prime2), 31) * Prime1;
+		high = rotateLeft(high + value * Prime4, 27) * Prime3 + low;
+	}
+
+	void Hasher::add(std::string_view text)
+	{
+		add(static_cast<std::uint64_t>(text.size()));
+		const char* bytes = text.data();
+		std::size_t size = text.size();
+		std::size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+			add(loadLittleEndian(bytes + i));
+		if (i != size)
+		{
+			char tail[8] = {};
+			std::memcpy(tail, bytes + i, size - i);
+			add(loadLittleEndian(tail));
+		}
+	}
+
+	void Hasher::add(const Hash128& hash)
+	{
+		add(hash.low);
+		add(hash.high);
+	}
+
+	Hash128 Hasher::finish() const
+	{
+		Hash128 hash;
+		hash.low = avalanche(low ^ length);
+		hash.high = avalanche(high ^ rotateLeft(low, 17));
+		return hash;
+	}
+
+	namespace AST {
+
+		namespace {
+			Hasher start(const Node* node)
+			{
+				Hasher hasher;
+				hasher.add(static_cast<std::uint64_t>(node->getKind()));
+				return hasher;
+			}
+
+			// Pre-order: kind, payload and, where the arity varies, child count
+			class StructuralHasher : public ExpressionVisitor<StructuralHasher>
+			{
+				Hasher& hasher;
+				const SymbolTable* symbols;
+
+				// The kind and a node's small fields go into one word
+				void header(const Node* node, std::uint64_t fields = 0)
+				{
+					hasher.add(static_cast<std::uint64_t>(node->getKind()) | fields << 8);
+				}
+
+				void leaf(const Node* node, std::string_view text)
+				{
+					header(node);
+					hasher.add(text);
+				}
+			public:
+				StructuralHasher(Hasher& hasher, const SymbolTable* symbols) : hasher(hasher), symbols(symbols) {}
+
+				void visitDeclarationVariable(const DeclarationVariable* node)
+				{
+					header(node, static_cast<std::uint64_t>(node->getIsMutable()) | static_cast<std::uint64_t>(node->getTypeIsInferred()) << 1);
+					hasher.add(symbols->getSpellingHash(node->getName()));
+					hasher.add(node->getType());
+				}
+
+				void visitBlock(const BlockExpression* node)
+				{
+					header(node);
+					visit(node->getInner());
+				}
+
+				void visitSequence(const SequenceExpression* node)
+				{
+					header(node, node->getStatements().size);
+					for (auto statement : node->getStatements())
+						visit(statement);
+				}
+
+				void visitNumber(const NumberExpression* node) { header(node, node->getIsFloat()); hasher.add(node->getValue()); }
+				void visitString(const StringExpression* node) { leaf(node, node->getValue()); }
+				void visitChar(const CharExpression* node) { leaf(node, node->getValue()); }
+				void visitIdentifier(const IdentifierExpression* node) { header(node); hasher.add(symbols->getSpellingHash(node->getValue())); }
+
+				void visitBinary(const BinaryExpression* node)
+				{
+					header(node, static_cast<std::uint64_t>(node->getType()));
+					visit(node->getLeft());
+					visit(node->getRight());
+				}
+
+				void visitUnary(const UnaryExpression* node)
+				{
+					header(node, static_cast<std::uint64_t>(node->getType()));
+					visit(node->getOperand());
+				}
+
+				void visitCall(const CallExpression* node)
+				{
+					header(node, node->getArguments().size);
+					visit(node->getCallee());
+					for (auto argument : node->getArguments())
+						visit(argument);
+				}
+
+				void visitIndex(const IndexExpression* node)
+				{
+					header(node);
+					visit(node->getTarget());
+					visit(node->getIndex());
+				}
+
+				void visitNop(const NOPExpression* node)
+				{
+					header(node);
+				}
+			};
+
+			class TopLevelHasher : public TopLevelVisitor<TopLevelHasher, Hash128>
+			{
+			public:
+				Hash128 visitModule(const Module* node) { return node->getHash(); }
+				Hash128 visitFunction(const DeclarationFunction* node) { return node->getHash(); }
+			};
+		}
+
+		Hash128 hashFunction(const DeclarationFunction* function, const SymbolTable* symbols)
+		{
+			Hasher hasher = start(function);
+			hasher.add(function->getName());
+			hasher.add(function->getReturnType());
+			hasher.add(static_cast<std::uint64_t>(function->getArguments().size));
+			for (auto argument : function->getArguments())
+			{
+				hasher.add(argument->getName());
+				hasher.add(argument->getType());
+			}
+			// A body that did not parse hashes as a NOP
+			BlockExpression* body = function->getBody();
+			if (body != nullptr)
+				StructuralHasher(hasher, symbols).visit(body);
+			else
+				hasher.add(static_cast<std::uint64_t>(NodeKind::NOP));
+			return hasher.finish();
+		}
+
+		Hash128 hashModule(const Module* module)
+		{
+			Hasher hasher = start(module);
+			hasher.add(module->getName());
+			hasher.add(static_cast<std::uint64_t>(module->getTopLevel().size));
+			TopLevelHasher children;
+			for (auto topLevel : module->getTopLevel())
+				hasher.add(children.visit(topLevel));
+			return hasher.finish();
+		}
+	}
+}
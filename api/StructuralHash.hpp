@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "SymbolTable.hpp"
+
+namespace ozToy {
+
+	struct Hash128
+	{
+		std::uint64_t low = 0;
+		std::uint64_t high = 0;
+		bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+		bool operator!=(const Hash128& other) const { return !(*this == other); }
+	};
+
+	// 128-bit hash, stable across runs and platforms; not cryptographic
+	class Hasher
+	{
+		std::uint64_t low;
+		std::uint64_t high;
+		std::uint64_t length;
+	public:
+		Hasher();
+		void add(std::uint64_t value);
+		// Length-prefixed
+		void add(std::string_view text);
+		void add(const Hash128& hash);
+		Hash128 finish() const;
+	};
+
+	namespace AST {
+		class DeclarationFunction;
+		class Module;
+
+		// Covers structure, names and literals, not offsets; names are hashed by spelling
+		Hash128 hashFunction(const DeclarationFunction* function, const SymbolTable* symbols);
+		Hash128 hashModule(const Module* module);
+	}
+}
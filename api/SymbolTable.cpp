@@ -0,0 +1,41 @@
+#include "SymbolTable.hpp"
+#include "StructuralHash.hpp"
+
+namespace ozToy {
+
+	SymbolTable::SymbolTable()
+	{
+		intern("");
+	}
+
+	SymbolId SymbolTable::intern(std::string_view name)
+	{
+		auto it = ids.find(name);
+		if (it != ids.end())
+			return it->second;
+
+		SymbolId id = static_cast<SymbolId>(names.size());
+		names.emplace_back(name);
+		ids.emplace(names.back(), id);
+		Hasher hasher;
+		hasher.add(name);
+		spellingHashes.push_back(hasher.finish().low);
+		return id;
+	}
+
+	const std::string& SymbolTable::getName(SymbolId id) const
+	{
+		return names[id];
+	}
+
+	std::size_t SymbolTable::size() const
+	{
+		return names.size();
+	}
+
+	SymbolTable* SymbolTable::getInstance()
+	{
+		static SymbolTable* instance = new SymbolTable();
+		return instance;
+	}
+}
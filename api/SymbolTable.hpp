@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ozToy {
+
+	using SymbolId = std::uint32_t;
+
+	// Interns identifier spellings into dense ids. Id 0 is always the empty name.
+	class SymbolTable
+	{
+		std::deque<std::string> names;
+		std::unordered_map<std::string_view, SymbolId> ids;
+		// Hasher digest of each spelling, so structural hashes need not touch the names
+		std::vector<std::uint64_t> spellingHashes;
+	public:
+		SymbolTable();
+		SymbolTable(const SymbolTable&) = delete;
+		SymbolTable& operator=(const SymbolTable&) = delete;
+		SymbolId intern(std::string_view name);
+		const std::string& getName(SymbolId id) const;
+		// Depends only on the spelling, never on the id
+		std::uint64_t getSpellingHash(SymbolId id) const { return spellingHashes[id]; }
+		std::size_t size() const;
+		static SymbolTable* getInstance();
+	};
+}
@@ -0,0 +1,90 @@
+#include "TokenPipe.hpp"
+
+namespace ozToy {
+
+	namespace {
+		// Spins briefly, then yields
+		void backOff(unsigned& spins)
+		{
+			if (++spins < 64)
+				return;
+			std::this_thread::yield();
+		}
+	}
+
+	TokenPipe::TokenPipe(SourceBuffer* source, SymbolTable* symbols)
+		: source(source), symbols(symbols), batches(new Batch[BatchCount]), head(0), cachedTail(0), tail(0), cachedHead(0), readIndex(0), finished(false), stopRequested(false)
+	{
+		producer = std::thread(&TokenPipe::produce, this);
+	}
+
+	TokenPipe::~TokenPipe()
+	{
+		stopRequested.store(true, std::memory_order_relaxed);
+		producer.join();
+		delete[] batches;
+	}
+
+	void TokenPipe::produce()
+	{
+		Scanner scanner(source, symbols);
+		std::size_t current = 0;
+		bool done = false;
+		while (!done)
+		{
+			unsigned spins = 0;
+			while (current - cachedTail == BatchCount)
+			{
+				if (stopRequested.load(std::memory_order_relaxed))
+					return;
+				backOff(spins);
+				cachedTail = tail.load(std::memory_order_acquire);
+			}
+			if (stopRequested.load(std::memory_order_relaxed))
+				return;
+
+			Batch& batch = batches[current % BatchCount];
+			std::size_t count = 0;
+			while (count < BatchSize)
+			{
+				const Token& token = scanner.getToken();
+				batch.tokens[count++] = token;
+				if (token.type == TokenType::END_OF_FILE)
+				{
+					done = true;
+					break;
+				}
+			}
+			batch.count = count;
+			head.store(++current, std::memory_order_release);
+		}
+	}
+
+	Token TokenPipe::next()
+	{
+		if (finished)
+			return endToken;
+
+		std::size_t current = tail.load(std::memory_order_relaxed);
+		unsigned spins = 0;
+		while (current == cachedHead)
+		{
+			backOff(spins);
+			cachedHead = head.load(std::memory_order_acquire);
+		}
+
+		const Batch& batch = batches[current % BatchCount];
+		Token token = batch.tokens[readIndex++];
+		if (readIndex == batch.count)
+		{
+			readIndex = 0;
+			tail.store(current + 1, std::memory_order_release);
+		}
+		if (token.type == TokenType::END_OF_FILE)
+		{
+			finished = true;
+			endToken = token;
+		}
+		return token;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#include "Scanner.hpp"
+
+namespace ozToy {
+
+	// Scans on its own thread into a bounded SPSC ring of token batches for one consumer.
+	// Read the symbol table only once next() has returned END_OF_FILE.
+	class TokenPipe
+	{
+	public:
+		static constexpr std::size_t BatchSize = 256;
+		static constexpr std::size_t BatchCount = 64;
+	private:
+		static constexpr std::size_t CacheLine = 64;
+
+		struct Batch
+		{
+			Token tokens[BatchSize];
+			std::size_t count;
+		};
+
+		SourceBuffer* source;
+		SymbolTable* symbols;
+		Batch* batches;
+		// Producer side: batches published so far, and the last tail it has seen
+		alignas(CacheLine) std::atomic<std::size_t> head;
+		std::size_t cachedTail;
+		// Consumer side: batches released so far, the last head it has seen and its place in the current batch
+		alignas(CacheLine) std::atomic<std::size_t> tail;
+		std::size_t cachedHead;
+		std::size_t readIndex;
+		bool finished;
+		Token endToken;
+		alignas(CacheLine) std::atomic<bool> stopRequested;
+		std::thread producer;
+		void produce();
+	public:
+		TokenPipe(SourceBuffer* source, SymbolTable* symbols = SymbolTable::getInstance());
+		TokenPipe(const TokenPipe&) = delete;
+		TokenPipe& operator=(const TokenPipe&) = delete;
+		~TokenPipe();
+		// Consumer thread only
+		Token next();
+		SourceBuffer* getSource() const { return source; }
+		// The table the producer interns into
+		SymbolTable* getSymbolTable() const { return symbols; }
+	};
+}
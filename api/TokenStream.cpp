@@ -0,0 +1,323 @@
+#include "TokenStream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace ozToy {
+
+	TokenStream::TokenStream(SourceBuffer* source, SymbolTable* symbolTable) : source(source), symbolTable(symbolTable)
+	{
+	}
+
+	void TokenStream::reserve(std::size_t count)
+	{
+		types.reserve(count);
+		offsets.reserve(count);
+		lengths.reserve(count);
+		symbols.reserve(count);
+	}
+
+	void TokenStream::push(const Token& token, std::size_t end)
+	{
+		if (token.type == TokenType::ERROR)
+			errorMessages.emplace_back(static_cast<std::uint32_t>(types.size()), token.text);
+		types.push_back(token.type);
+		offsets.push_back(token.offset);
+		lengths.push_back(static_cast<std::uint32_t>(end - token.offset));
+		if (hasNumber(token.type))
+		{
+			symbols.push_back(static_cast<SymbolId>(numbers.size()));
+			numbers.push_back(token.number);
+		}
+		else
+			symbols.push_back(token.symbol);
+	}
+
+	Token TokenStream::get(std::size_t index) const
+	{
+		if (index >= types.size())
+			index = types.size() - 1;
+
+		// STRING and CHAR text is the literal body without its quotes
+		std::uint32_t textOffset = offsets[index];
+		std::uint32_t textLength = lengths[index];
+		if (types[index] == TokenType::STRING || types[index] == TokenType::CHAR)
+		{
+			++textOffset;
+			textLength -= 2;
+		}
+
+		Token token{ types[index], std::string_view(source->begin() + textOffset, textLength), 0, offsets[index] };
+		if (hasNumber(token.type))
+			token.number = numbers[symbols[index]];
+		else
+			token.symbol = symbols[index];
+		if (token.type == TokenType::ERROR)
+		{
+			auto it = std::lower_bound(errorMessages.begin(), errorMessages.end(), std::make_pair(static_cast<std::uint32_t>(index), std::string_view()));
+			token.text = it->second;
+		}
+		return token;
+	}
+
+	std::size_t TokenStream::getMemoryUsage() const
+	{
+		return types.capacity() * sizeof(TokenType)
+			+ offsets.capacity() * sizeof(std::uint32_t)
+			+ lengths.capacity() * sizeof(std::uint32_t)
+			+ symbols.capacity() * sizeof(SymbolId)
+			+ numbers.capacity() * sizeof(std::uint64_t)
+			+ errorMessages.capacity() * sizeof(errorMessages[0]);
+	}
+
+	TokenStream* TokenStream::lex(SourceBuffer* source, SymbolTable* symbols)
+	{
+		TokenStream* stream = new TokenStream(source, symbols);
+
+		// Generated sources average a little over five bytes per token
+		stream->reserve(source->getSize() / 5 + 1);
+
+		Scanner scanner(source, symbols);
+		while (true)
+		{
+			const Token& token = scanner.getToken();
+			stream->push(token, scanner.mark());
+			if (token.type == TokenType::END_OF_FILE)
+				break;
+		}
+		return stream;
+	}
+
+	void TokenStream::append(const TokenStream& other, std::size_t begin, std::size_t end, std::vector<SymbolId>& symbolMap)
+	{
+		for (auto& error : other.errorMessages)
+		{
+			if (begin <= error.first && error.first < end)
+				errorMessages.emplace_back(static_cast<std::uint32_t>(types.size() + error.first - begin), error.second);
+		}
+
+		types.insert(types.end(), other.types.begin() + begin, other.types.begin() + end);
+		offsets.insert(offsets.end(), other.offsets.begin() + begin, other.offsets.begin() + end);
+		lengths.insert(lengths.end(), other.lengths.begin() + begin, other.lengths.begin() + end);
+
+		// Intern in token order so ids come out as if the file had been lexed serially
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			if (hasNumber(other.types[i]))
+			{
+				this->symbols.push_back(static_cast<SymbolId>(numbers.size()));
+				numbers.push_back(other.numbers[other.symbols[i]]);
+				continue;
+			}
+			SymbolId& mapped = symbolMap[other.symbols[i]];
+			if (mapped == UnmappedSymbol)
+				mapped = symbolTable->intern(other.symbolTable->getName(other.symbols[i]));
+			this->symbols.push_back(mapped);
+		}
+	}
+
+	std::size_t TokenStream::find(std::uint32_t offset, std::size_t from) const
+	{
+		auto it = std::lower_bound(offsets.begin() + from, offsets.end(), offset);
+		if (it == offsets.end() || *it != offset)
+			return NotFound;
+		return static_cast<std::size_t>(it - offsets.begin());
+	}
+
+	TokenStream* TokenStream::lexRange(SourceBuffer* source, std::size_t begin, std::size_t end, SymbolTable* symbols, std::uint32_t& nextOffset)
+	{
+		TokenStream* stream = new TokenStream(source, symbols);
+		stream->reserve((std::min(end, source->getSize()) - begin) / 5 + 1);
+
+		Scanner scanner(source, symbols);
+		scanner.rewind(begin);
+		while (true)
+		{
+			const Token& token = scanner.getToken();
+			if (token.offset >= end)
+			{
+				nextOffset = token.offset;
+				break;
+			}
+			stream->push(token, scanner.mark());
+			if (token.type == TokenType::END_OF_FILE)
+				break;
+		}
+		return stream;
+	}
+
+	TokenStream* TokenStream::lexParallel(SourceBuffer* source, std::size_t threadCount, SymbolTable* symbols)
+	{
+		// Below this a chunk is not worth a thread
+		const std::size_t MinChunkSize = std::size_t(1) << 20;
+
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		std::size_t chunkCount = std::min(threadCount, source->getSize() / MinChunkSize);
+		if (chunkCount <= 1)
+			return lex(source, symbols);
+
+		// Cut after a newline; a cut inside a literal is repaired while stitching
+		std::vector<std::size_t> starts{ 0 };
+		for (std::size_t i = 1; i < chunkCount; ++i)
+		{
+			std::size_t target = source->getSize() * i / chunkCount;
+			const void* newline = std::memchr(source->begin() + target, '\n', source->getSize() - target);
+			if (newline == nullptr)
+				break;
+			std::size_t start = static_cast<const char*>(newline) - source->begin() + 1;
+			if (start > starts.back() && start < source->getSize())
+				starts.push_back(start);
+		}
+		chunkCount = starts.size();
+
+		std::vector<std::size_t> ends(chunkCount);
+		for (std::size_t i = 0; i < chunkCount; ++i)
+			ends[i] = i + 1 < chunkCount ? starts[i + 1] : static_cast<std::size_t>(-1);
+
+		std::vector<TokenStream*> chunks(chunkCount);
+		std::vector<SymbolTable*> chunkSymbols(chunkCount);
+		std::vector<std::uint32_t> nextOffsets(chunkCount);
+		std::vector<std::thread> workers;
+		for (std::size_t i = 0; i < chunkCount; ++i)
+		{
+			chunkSymbols[i] = new SymbolTable();
+			workers.emplace_back([&, i] {
+				chunks[i] = lexRange(source, starts[i], ends[i], chunkSymbols[i], nextOffsets[i]);
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+
+		std::size_t total = 0;
+		for (auto chunk : chunks)
+			total += chunk->size();
+
+		TokenStream* stream = new TokenStream(source, symbols);
+		stream->reserve(total);
+
+		// Offset where the serial lexer would start its next token
+		std::uint32_t resume = 0;
+		Scanner rescanner(source, symbols);
+		for (std::size_t i = 0; i < chunkCount; ++i)
+		{
+			TokenStream* chunk = chunks[i];
+			std::size_t from = chunk->find(resume, 0);
+
+			// The previous token ran past the cut; re-lex until a token start agrees
+			if (from == NotFound)
+			{
+				rescanner.rewind(resume);
+				while (true)
+				{
+					const Token& token = rescanner.getToken();
+					if (token.offset >= ends[i])
+					{
+						resume = token.offset;
+						break;
+					}
+					from = chunk->find(token.offset, 0);
+					if (from != NotFound)
+						break;
+					stream->push(token, rescanner.mark());
+				}
+			}
+
+			if (from != NotFound)
+			{
+				std::vector<SymbolId> symbolMap(chunkSymbols[i]->size(), UnmappedSymbol);
+				symbolMap[0] = 0;
+				stream->append(*chunk, from, chunk->size(), symbolMap);
+				resume = nextOffsets[i];
+			}
+
+			delete chunk;
+			delete chunkSymbols[i];
+		}
+
+		return stream;
+	}
+
+	TokenDelta TokenStream::relex(const SourceEdit& edit, SourceBuffer* editedSource) const
+	{
+		// The scanner looks up to three bytes past a token
+		const std::size_t Lookahead = 3;
+		std::size_t first = static_cast<std::size_t>(std::lower_bound(offsets.begin(), offsets.end(), static_cast<std::uint32_t>(edit.offset)) - offsets.begin());
+		while (first > 0 && std::size_t(offsets[first - 1]) + lengths[first - 1] + Lookahead > edit.offset)
+			--first;
+		std::size_t restart = first > 0 ? std::size_t(offsets[first - 1]) + lengths[first - 1] : 0;
+
+		std::int64_t offsetDelta = static_cast<std::int64_t>(edit.insertedText.size()) - static_cast<std::int64_t>(edit.removedLength);
+		TokenDelta delta{ first, 0, offsetDelta, TokenStream(editedSource, symbolTable) };
+
+		Scanner scanner(editedSource, symbolTable);
+		scanner.rewind(restart);
+		while (true)
+		{
+			const Token& token = scanner.getToken();
+
+			// Resynchronized once a token starts where an old one did
+			if (token.offset >= edit.offset + edit.insertedText.size())
+			{
+				std::size_t match = find(static_cast<std::uint32_t>(token.offset - offsetDelta), first);
+				if (match != NotFound)
+				{
+					delta.removedCount = match - first;
+					break;
+				}
+			}
+			delta.inserted.push(token, scanner.mark());
+		}
+		return delta;
+	}
+
+	void TokenStream::applyDelta(const TokenDelta& delta)
+	{
+		std::size_t removedEnd = delta.firstIndex + delta.removedCount;
+		std::int64_t indexDelta = static_cast<std::int64_t>(delta.inserted.size()) - static_cast<std::int64_t>(delta.removedCount);
+
+		std::vector<std::pair<std::uint32_t, std::string_view>> errors;
+		for (auto& error : errorMessages)
+		{
+			if (error.first < delta.firstIndex)
+				errors.push_back(error);
+		}
+		for (auto& error : delta.inserted.errorMessages)
+			errors.emplace_back(static_cast<std::uint32_t>(delta.firstIndex + error.first), error.second);
+		for (auto& error : errorMessages)
+		{
+			if (error.first >= removedEnd)
+				errors.emplace_back(static_cast<std::uint32_t>(error.first + indexDelta), error.second);
+		}
+		errorMessages.swap(errors);
+
+		for (std::size_t i = removedEnd; i < offsets.size(); ++i)
+			offsets[i] = static_cast<std::uint32_t>(offsets[i] + delta.offsetDelta);
+
+		types.erase(types.begin() + delta.firstIndex, types.begin() + removedEnd);
+		types.insert(types.begin() + delta.firstIndex, delta.inserted.types.begin(), delta.inserted.types.end());
+		offsets.erase(offsets.begin() + delta.firstIndex, offsets.begin() + removedEnd);
+		offsets.insert(offsets.begin() + delta.firstIndex, delta.inserted.offsets.begin(), delta.inserted.offsets.end());
+		lengths.erase(lengths.begin() + delta.firstIndex, lengths.begin() + removedEnd);
+		lengths.insert(lengths.begin() + delta.firstIndex, delta.inserted.lengths.begin(), delta.inserted.lengths.end());
+		symbols.erase(symbols.begin() + delta.firstIndex, symbols.begin() + removedEnd);
+		symbols.insert(symbols.begin() + delta.firstIndex, delta.inserted.symbols.begin(), delta.inserted.symbols.end());
+
+		// Renumbered in token order
+		std::size_t insertedEnd = delta.firstIndex + delta.inserted.size();
+		std::vector<std::uint64_t> values;
+		values.reserve(numbers.size() + delta.inserted.numbers.size());
+		for (std::size_t i = 0; i < types.size(); ++i)
+		{
+			if (!hasNumber(types[i]))
+				continue;
+			bool inserted = delta.firstIndex <= i && i < insertedEnd;
+			values.push_back(inserted ? delta.inserted.numbers[symbols[i]] : numbers[symbols[i]]);
+			symbols[i] = static_cast<SymbolId>(values.size() - 1);
+		}
+		numbers.swap(values);
+
+		source = delta.inserted.source;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Scanner.hpp"
+
+namespace ozToy {
+
+	struct TokenDelta;
+
+	// Whole file lexed up front into a structure-of-arrays token buffer.
+	// The last token is always END_OF_FILE, and reads past the end keep returning it.
+	class TokenStream
+	{
+		static constexpr std::size_t NotFound = static_cast<std::size_t>(-1);
+		static constexpr SymbolId UnmappedSymbol = static_cast<SymbolId>(-1);
+
+		SourceBuffer* source;
+		// The table the symbol ids index into
+		SymbolTable* symbolTable;
+		std::vector<TokenType> types;
+		std::vector<std::uint32_t> offsets;
+		// In the source, quotes included
+		std::vector<std::uint32_t> lengths;
+		// For NUMBER and FLOAT, the index into numbers
+		std::vector<SymbolId> symbols;
+		std::vector<std::uint64_t> numbers;
+		// ERROR tokens keep their message here, keyed by token index
+		std::vector<std::pair<std::uint32_t, std::string_view>> errorMessages;
+		static bool hasNumber(TokenType type) { return type == TokenType::NUMBER || type == TokenType::FLOAT; }
+		void reserve(std::size_t count);
+		void append(const TokenStream& other, std::size_t begin, std::size_t end, std::vector<SymbolId>& symbolMap);
+		std::size_t find(std::uint32_t offset, std::size_t from) const;
+		static TokenStream* lexRange(SourceBuffer* source, std::size_t begin, std::size_t end, SymbolTable* symbols, std::uint32_t& nextOffset);
+	public:
+		TokenStream(SourceBuffer* source, SymbolTable* symbolTable = SymbolTable::getInstance());
+		// end is the source offset just past the token
+		void push(const Token& token, std::size_t end);
+		std::size_t size() const { return types.size(); }
+		TokenType getType(std::size_t index) const { return types[index < types.size() ? index : types.size() - 1]; }
+		std::uint32_t getOffset(std::size_t index) const { return offsets[index < offsets.size() ? index : offsets.size() - 1]; }
+		Token get(std::size_t index) const;
+		SourceBuffer* getSource() const { return source; }
+		SymbolTable* getSymbolTable() const { return symbolTable; }
+		std::size_t getMemoryUsage() const;
+		static TokenStream* lex(SourceBuffer* source, SymbolTable* symbols = SymbolTable::getInstance());
+		// Same stream as lex(), symbol ids included; threadCount 0 means one per core
+		static TokenStream* lexParallel(SourceBuffer* source, std::size_t threadCount = 0, SymbolTable* symbols = SymbolTable::getInstance());
+		// Re-lexes only the tokens the edit can affect; editedSource has it applied
+		TokenDelta relex(const SourceEdit& edit, SourceBuffer* editedSource) const;
+		// Turns this stream into the stream of delta's edited source.
+		void applyDelta(const TokenDelta& delta);
+	};
+
+	// Replaces removedCount tokens at firstIndex; later offsets move by offsetDelta
+	struct TokenDelta
+	{
+		std::size_t firstIndex;
+		std::size_t removedCount;
+		std::int64_t offsetDelta;
+		TokenStream inserted;
+	};
+}
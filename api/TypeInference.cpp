@@ -0,0 +1,297 @@
+#include "TypeInference.hpp"
+
+namespace ozToy::HIR {
+
+	namespace {
+		// Literals and the unit value are shared, so they are never numbered
+		bool isShared(const Value* value)
+		{
+			return value->getKind() == ValueKind::LITERAL || value->getKind() == ValueKind::UNIT;
+		}
+
+		Variable* asVariable(Value* value)
+		{
+			bool named = value->getKind() == ValueKind::VARIABLE || value->getKind() == ValueKind::UNRESOLVED_VARIABLE;
+			return named ? static_cast<Variable*>(value) : nullptr;
+		}
+	}
+
+	TypeInference::TypeInference(TranslationUnit* tu) : tu(tu)
+	{
+		boolType = PrimitiveType::lookup("bool");
+		unitType = PrimitiveType::lookup("unit");
+	}
+
+	std::uint32_t TypeInference::fresh(Value* value)
+	{
+		std::uint32_t variable = static_cast<std::uint32_t>(parents.size());
+		parents.push_back(variable);
+		ranks.push_back(0);
+		types.push_back(nullptr);
+		values.push_back(value);
+		return variable;
+	}
+
+	std::uint32_t TypeInference::find(std::uint32_t variable)
+	{
+		std::uint32_t root = variable;
+		while (parents[root] != root)
+			root = parents[root];
+		// Path compression
+		while (parents[variable] != root)
+		{
+			std::uint32_t next = parents[variable];
+			parents[variable] = root;
+			variable = next;
+		}
+		return root;
+	}
+
+	void TypeInference::bind(std::uint32_t variable, Type* type, const Value* at)
+	{
+		if (type == nullptr)
+			return;
+		std::uint32_t root = find(variable);
+		if (types[root] == nullptr)
+			types[root] = type;
+		else if (types[root] != type)
+			conflicts.push_back({ at, types[root], type });
+	}
+
+	void TypeInference::unify(std::uint32_t first, std::uint32_t second, const Value* at)
+	{
+		std::uint32_t a = find(first);
+		std::uint32_t b = find(second);
+		if (a == b)
+			return;
+		if (types[a] != nullptr && types[b] != nullptr && types[a] != types[b])
+		{
+			conflicts.push_back({ at, types[a], types[b] });
+			return;
+		}
+
+		// Union by rank
+		if (ranks[a] < ranks[b])
+			std::swap(a, b);
+		parents[b] = a;
+		if (ranks[a] == ranks[b])
+			++ranks[a];
+		if (types[a] == nullptr)
+			types[a] = types[b];
+	}
+
+	Type* TypeInference::canonical(Type* type)
+	{
+		// Replaced by what it is bound to, so every int is the literals' int
+		if (type != nullptr && type->getKind() == TypeKind::NAMED)
+		{
+			auto named = static_cast<UnresolvedType*>(type);
+			if (named->getPrimitive() != nullptr)
+				return named->getPrimitive();
+			if (named->getStruct() != nullptr)
+				return named->getStruct();
+			if (named->getClass() != nullptr)
+				return named->getClass();
+		}
+		return type;
+	}
+
+	Type* TypeInference::getSignature(const FunctionImpl* function)
+	{
+		auto it = signatures.find(function);
+		if (it != signatures.end())
+			return it->second;
+
+		std::vector<Type*> parameters;
+		parameters.reserve(function->getArguments().size());
+		for (auto argument : function->getArguments())
+			parameters.push_back(canonical(argument->getType()));
+		Type* result = function->getReturnType() != nullptr ? canonical(function->getReturnType()) : unitType;
+		Type* signature = tu->getTypes().getFunction(parameters, result);
+		signatures.emplace(function, signature);
+		return signature;
+	}
+
+	std::uint32_t TypeInference::constrain(Value* value)
+	{
+		// Each use of a shared value gets a variable of its own, bound to the value's fixed type
+		if (isShared(value))
+		{
+			std::uint32_t use = fresh(nullptr);
+			bind(use, value->getKind() == ValueKind::UNIT ? unitType : value->getType(), value);
+			return use;
+		}
+		// A variable is met once per use but has one type
+		Variable* named = asVariable(value);
+		if (named != nullptr && named->getTypeVariable() != Variable::NoTypeVariable)
+			return named->getTypeVariable();
+
+		std::uint32_t variable = fresh(value);
+		if (named != nullptr)
+			named->setTypeVariable(variable);
+		switch (value->getKind())
+		{
+		case ValueKind::VARIABLE:
+			bind(variable, canonical(value->getType()), value);
+			break;
+		case ValueKind::UNRESOLVED_VARIABLE:
+		{
+			auto unresolved = static_cast<UnresolvedVariable*>(value);
+			if (unresolved->getArgument() != nullptr)
+				bind(variable, canonical(unresolved->getArgument()->getType()), value);
+			else if (unresolved->getTarget() != nullptr)
+				bind(variable, getSignature(static_cast<FunctionImpl*>(unresolved->getTarget())), value);
+			break;
+		}
+		case ValueKind::CALL:
+		{
+			auto call = static_cast<Call*>(value);
+			std::uint32_t callee = constrain(call->getCallee());
+			const std::vector<Value*>& arguments = call->getArguments();
+			std::vector<std::uint32_t> argumentVariables;
+			argumentVariables.reserve(arguments.size());
+			for (auto argument : arguments)
+				argumentVariables.push_back(constrain(argument));
+
+			// A callee of unknown type leaves the result unconstrained
+			Type* calleeType = types[find(callee)];
+			if (calleeType == nullptr || calleeType->getKind() != TypeKind::FUNCTION)
+				break;
+			auto signature = static_cast<FunctionType*>(calleeType);
+			if (signature->getParameters().size() != arguments.size())
+			{
+				conflicts.push_back({ value, signature, nullptr });
+				break;
+			}
+			for (std::size_t i = 0; i < arguments.size(); ++i)
+				bind(argumentVariables[i], signature->getParameters()[i], isShared(arguments[i]) ? value : arguments[i]);
+			bind(variable, signature->getResult(), value);
+			break;
+		}
+		case ValueKind::ASSIGN:
+		{
+			auto assign = static_cast<Assign*>(value);
+			std::uint32_t assigned = constrain(assign->getValue());
+			unify(constrain(assign->getTarget()), assigned, value);
+			bind(variable, unitType, value);
+			break;
+		}
+		case ValueKind::BINARY_OP:
+		{
+			auto binary = static_cast<BinaryOp*>(value);
+			std::uint32_t left = constrain(binary->getLeft());
+			std::uint32_t right = constrain(binary->getRight());
+			switch (binary->getOperator())
+			{
+			// The shift count need not have the type of what is shifted
+			case BinaryOperatorType::LEFT_SHIFT:
+			case BinaryOperatorType::RIGHT_SHIFT:
+				unify(variable, left, value);
+				break;
+			case BinaryOperatorType::LEFT_SHIFT_EQUAL:
+			case BinaryOperatorType::RIGHT_SHIFT_EQUAL:
+				bind(variable, unitType, value);
+				break;
+			case BinaryOperatorType::LESS:
+			case BinaryOperatorType::GREATER:
+			case BinaryOperatorType::LESS_EQUAL:
+			case BinaryOperatorType::GREATER_EQUAL:
+			case BinaryOperatorType::EQUAL:
+			case BinaryOperatorType::NOT_EQUAL:
+				unify(left, right, value);
+				bind(variable, boolType, value);
+				break;
+			case BinaryOperatorType::COND_AND:
+			case BinaryOperatorType::COND_OR:
+				bind(left, boolType, value);
+				bind(right, boolType, value);
+				bind(variable, boolType, value);
+				break;
+			case BinaryOperatorType::PLUS_EQUAL:
+			case BinaryOperatorType::MINUS_EQUAL:
+			case BinaryOperatorType::MULTIPLY_EQUAL:
+			case BinaryOperatorType::DIVIDE_EQUAL:
+			case BinaryOperatorType::MODULO_EQUAL:
+			case BinaryOperatorType::AND_EQUAL:
+			case BinaryOperatorType::OR_EQUAL:
+			case BinaryOperatorType::XOR_EQUAL:
+				unify(left, right, value);
+				bind(variable, unitType, value);
+				break;
+			// Arithmetic and bitwise operators take and give one type
+			default:
+				unify(left, right, value);
+				unify(variable, left, value);
+				break;
+			}
+			break;
+		}
+		case ValueKind::UNARY_OP:
+		{
+			auto unary = static_cast<UnaryOp*>(value);
+			std::uint32_t operand = constrain(unary->getOperand());
+			if (unary->getOperator() == UnaryOperatorType::NOT)
+			{
+				bind(operand, boolType, value);
+				bind(variable, boolType, value);
+			}
+			else
+				unify(variable, operand, value);
+			break;
+		}
+		case ValueKind::BLOCK:
+		{
+			// A block has the type of its last value, and an empty one is unit
+			const std::vector<Value*>& children = static_cast<Block*>(value)->getValues();
+			if (children.empty())
+				bind(variable, unitType, value);
+			for (std::size_t i = 0; i < children.size(); ++i)
+			{
+				std::uint32_t child = constrain(children[i]);
+				if (i + 1 == children.size())
+					unify(variable, child, value);
+			}
+			break;
+		}
+		case ValueKind::LITERAL:
+		case ValueKind::UNIT:
+			break;
+		}
+		return variable;
+	}
+
+	std::size_t TypeInference::inferFunction(FunctionImpl* function)
+	{
+		std::size_t conflictsBefore = conflicts.size();
+		parents.clear();
+		ranks.clear();
+		types.clear();
+		values.clear();
+
+		Block* root = function->getRootBlock();
+		std::uint32_t body = constrain(root);
+		// Reported at the body, which has a source offset; the root block does not
+		const Value* at = root->getValues().empty() ? root : root->getValues().back();
+		Type* returnType = function->getReturnType() != nullptr ? canonical(function->getReturnType()) : nullptr;
+		bind(body, returnType, at);
+
+		for (std::uint32_t variable = 0; variable < values.size(); ++variable)
+		{
+			Value* value = values[variable];
+			if (value == nullptr)
+				continue;
+			value->setType(types[find(variable)]);
+			if (Variable* named = asVariable(value))
+				named->setTypeVariable(Variable::NoTypeVariable);
+		}
+		return conflicts.size() - conflictsBefore;
+	}
+
+	std::size_t TypeInference::run()
+	{
+		std::size_t found = 0;
+		for (auto function : tu->getFunctions())
+			found += inferFunction(function);
+		return found;
+	}
+}
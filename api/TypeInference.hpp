@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "HIR.hpp"
+
+namespace ozToy::HIR {
+
+	// Unification over a union-find of type variables, one per value. Run after resolveNames.
+	class TypeInference
+	{
+	public:
+		// Where two concrete types met; found is null when a call has the wrong number of arguments
+		struct Conflict
+		{
+			const Value* value;
+			Type* expected;
+			Type* found;
+		};
+	private:
+		TranslationUnit* tu;
+		// Indexed by type variable; only a representative's types entry is meaningful
+		std::vector<std::uint32_t> parents;
+		std::vector<std::uint8_t> ranks;
+		std::vector<Type*> types;
+		std::vector<Value*> values;
+		std::vector<Conflict> conflicts;
+		std::unordered_map<const FunctionImpl*, Type*> signatures;
+		PrimitiveType* boolType;
+		PrimitiveType* unitType;
+
+		std::uint32_t fresh(Value* value);
+		std::uint32_t find(std::uint32_t variable);
+		void bind(std::uint32_t variable, Type* type, const Value* at);
+		void unify(std::uint32_t first, std::uint32_t second, const Value* at);
+		Type* canonical(Type* type);
+		Type* getSignature(const FunctionImpl* function);
+		std::uint32_t constrain(Value* value);
+	public:
+		TypeInference(TranslationUnit* tu);
+		// Sets each value's type, null where unconstrained; returns the number of conflicts
+		std::size_t inferFunction(FunctionImpl* function);
+		// Every function of the unit; returns the number of conflicts
+		std::size_t run();
+		const std::vector<Conflict>& getConflicts() const { return conflicts; }
+	};
+}
@@ -1,75 +1,100 @@
 #pragma once
 
+#include <cstdint>
+
+// Token kinds without a fixed spelling
+#define OZTOY_LITERAL_TOKENS(X) \
+	X(END_OF_FILE) \
+	X(IDENTIFIER) \
+	X(NUMBER) \
+	X(FLOAT) \
+	X(STRING) \
+	X(CHAR)
+
+// Operators and punctuators: X(token, spelling)
+#define OZTOY_PUNCTUATOR_TOKENS(X) \
+	X(LEFT_PAREN, "(") \
+	X(RIGHT_PAREN, ")") \
+	X(LEFT_BRACE, "{") \
+	X(RIGHT_BRACE, "}") \
+	X(LEFT_BRACKET, "[") \
+	X(RIGHT_BRACKET, "]") \
+	X(COMMA, ",") \
+	X(DOT, ".") \
+	X(SEMICOLON, ";") \
+	X(PLUS, "+") \
+	X(MINUS, "-") \
+	X(STAR, "*") \
+	X(SLASH, "/") \
+	X(PERCENT, "%") \
+	X(CARET, "^") \
+	X(AMPERSAND, "&") \
+	X(PIPE, "|") \
+	X(AMPERSAND_AMPERSAND, "&&") \
+	X(PIPE_PIPE, "||") \
+	X(TILDE, "~") \
+	X(BANG, "!") \
+	X(QUESTION, "?") \
+	X(COLON, ":") \
+	X(EQUAL, "=") \
+	X(LESS, "<") \
+	X(GREATER, ">") \
+	X(PLUS_EQUAL, "+=") \
+	X(MINUS_EQUAL, "-=") \
+	X(STAR_EQUAL, "*=") \
+	X(SLASH_EQUAL, "/=") \
+	X(PERCENT_EQUAL, "%=") \
+	X(AMPERSAND_EQUAL, "&=") \
+	X(PIPE_EQUAL, "|=") \
+	X(CARET_EQUAL, "^=") \
+	X(ASSIGN, ":=") \
+	X(PLUS_PLUS, "++") \
+	X(MINUS_MINUS, "--") \
+	X(LESS_LESS, "<<") \
+	X(GREATER_GREATER, ">>") \
+	X(LESS_EQUAL, "<=") \
+	X(GREATER_EQUAL, ">=") \
+	X(LESS_LESS_EQUAL, "<<=") \
+	X(GREATER_GREATER_EQUAL, ">>=") \
+	X(EQUAL_EQUAL, "==") \
+	X(BANG_EQUAL, "!=") \
+	X(ARROW, "->")
+
+// Keywords: X(token, spelling)
+#define OZTOY_KEYWORD_TOKENS(X) \
+	X(LET, "let") \
+	X(VAR, "var") \
+	X(CLASS, "class") \
+	X(STRUCT, "struct") \
+	X(ENUM, "enum") \
+	X(MODULE, "module") \
+	X(FN, "fn") \
+	X(IF, "if") \
+	X(THEN, "then") \
+	X(ELSE, "else") \
+	X(TRUE, "true") \
+	X(FALSE, "false") \
+	X(LOOP, "loop") \
+	X(FOR, "for") \
+	X(WHILE, "while")
+
+#define OZTOY_SPECIAL_TOKENS(X) \
+	X(OTHER) \
+	X(ERROR)
+
 namespace ozToy {
-	enum class TokenType {
-		END_OF_FILE,
-		IDENTIFIER,
-		NUMBER,
-		STRING,
-		CHAR,
-		LEFT_PAREN,
-		RIGHT_PAREN,
-		LEFT_BRACE,
-		RIGHT_BRACE,
-		LEFT_BRACKET,
-		RIGHT_BRACKET,
-		COMMA,
-		DOT,
-		SEMICOLON,
-		PLUS,
-		MINUS,
-		STAR,
-		SLASH,
-		PERCENT,
-		CARET,
-		AMPERSAND,
-		PIPE,
-		AMPERSAND_AMPERSAND,
-		PIPE_PIPE,
-		TILDE,
-		BANG,
-		QUESTION,
-		COLON,
-		EQUAL,
-		LESS,
-		GREATER,
-		PLUS_EQUAL,
-		MINUS_EQUAL,
-		STAR_EQUAL,
-		SLASH_EQUAL,
-		PERCENT_EQUAL,
-		AMPERSAND_EQUAL,
-		PIPE_EQUAL,
-		CARET_EQUAL,
-		ASSIGN,
-		PLUS_PLUS,
-		MINUS_MINUS,
-		LESS_LESS,
-		GREATER_GREATER,
-		LESS_EQUAL,
-		GREATER_EQUAL,
-		LESS_LESS_EQUAL,
-		GREATER_GREATER_EQUAL,
-		EQUAL_EQUAL,
-		BANG_EQUAL,
-		ARROW,
-		LET,
-		VAR,
-		CLASS,
-		STRUCT,
-		ENUM,
-		MODULE,
-		FN,
-		IF,
-		THEN,
-		ELSE,
-		TRUE,
-		FALSE,
-		OTHER,
-		ERROR,
+	enum class TokenType : std::uint8_t {
+#define OZTOY_TOKEN_ENUM(name) name,
+#define OZTOY_SPELLED_TOKEN_ENUM(name, spelling) name,
+		OZTOY_LITERAL_TOKENS(OZTOY_TOKEN_ENUM)
+		OZTOY_PUNCTUATOR_TOKENS(OZTOY_SPELLED_TOKEN_ENUM)
+		OZTOY_KEYWORD_TOKENS(OZTOY_SPELLED_TOKEN_ENUM)
+		OZTOY_SPECIAL_TOKENS(OZTOY_TOKEN_ENUM)
+#undef OZTOY_SPELLED_TOKEN_ENUM
+#undef OZTOY_TOKEN_ENUM
 	};
 
-	enum class BinaryOperatorType {
+	enum class BinaryOperatorType : std::uint8_t {
 		PLUS, // +
 		MINUS, // -
 		MULTIPLY, // *
@@ -104,7 +129,7 @@ namespace ozToy {
 		END,
 	};
 
-	const std::uint8_t BinaryOperatorPriority[] = {
+	constexpr std::uint8_t BinaryOperatorPriority[] = {
 		10, // +
 		10, // -
 		11, // *
@@ -139,14 +164,18 @@ namespace ozToy {
 		0, // END
 	};
 
-	enum class ExpressionParseOperation {
-		SHIFT,
-		REDUCE,
-		ACCEPT,
-		ERROR,
+	// Assignments, the lowest priority, evaluate their right operand first
+	constexpr bool evaluatesRightFirst(BinaryOperatorType type) {
+		return BinaryOperatorPriority[static_cast<std::size_t>(type)] == 1;
+	}
+
+	enum class UnaryOperatorType : std::uint8_t {
+		NOT, // !
+		COMPLEMENT, // ~
+		NEGATE, // -
 	};
 
-	inline BinaryOperatorType binaryOperatorTypeFromTokenType(TokenType type) {
+	constexpr BinaryOperatorType binaryOperatorTypeFromTokenType(TokenType type) {
 		switch (type) {
 		case TokenType::PLUS:
 			return BinaryOperatorType::PLUS;
@@ -185,9 +214,9 @@ namespace ozToy {
 		case TokenType::EQUAL:
 			return BinaryOperatorType::SUBSTITUTE;
 		case TokenType::AMPERSAND_AMPERSAND:
-			return BinaryOperatorType::AND;
+			return BinaryOperatorType::COND_AND;
 		case TokenType::PIPE_PIPE:
-			return BinaryOperatorType::OR;
+			return BinaryOperatorType::COND_OR;
 		case TokenType::CARET:
 			return BinaryOperatorType::XOR;
 		case TokenType::AMPERSAND:
@@ -212,23 +241,4 @@ namespace ozToy {
 			return BinaryOperatorType::END;
 		}
 	}
-
-	inline ExpressionParseOperation getOperation(BinaryOperatorType left, BinaryOperatorType right) {
-		if (left == BinaryOperatorType::START && right == BinaryOperatorType::END) {
-			return ExpressionParseOperation::ACCEPT;
-		}
-		
-		std::uint8_t leftPriority = BinaryOperatorPriority[static_cast<std::uint8_t>(left)];
-		std::uint8_t rightPriority = BinaryOperatorPriority[static_cast<std::uint8_t>(right)];
-
-		if (leftPriority == 1 && rightPriority == 1) {
-			return ExpressionParseOperation::SHIFT;
-		}
-		else if (leftPriority >= rightPriority) {
-			return ExpressionParseOperation::REDUCE;
-		}
-		else {
-			return ExpressionParseOperation::SHIFT;
-		}
-	}
 }
\ No newline at end of file
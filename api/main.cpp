@@ -1,31 +1,63 @@
 #include <iostream>
 #include <string>
-#include <fstream>
+#include "SourceBuffer.hpp"
 #include "Scanner.hpp"
 #include "AST.hpp"
 #include "HIRBuilder.hpp"
+#include "TypeInference.hpp"
 
-int main() {
+int main(int argc, char** argv) {
 	std::string fileNmae = "test.txt";
-	std::ifstream file(fileNmae);
-	if (!file.is_open()) {
+	// --stream lowers one function at a time instead of parsing the whole file first
+	bool streaming = argc > 1 && std::string(argv[1]) == "--stream";
+	ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromFile(fileNmae);
+	if (source == nullptr) {
 		std::cout << "Error opening file: " << fileNmae << std::endl;
 		return 1;
 	}
-	ozToy::Scanner scanner(&file);
+	ozToy::Scanner scanner(source);
+
+	if (streaming) {
+		ozToy::HIR::TranslationUnit tu;
+		ozToy::HIR::ModuleBuilder mBuilder(tu.getRootModule());
+		std::size_t peakBytes = 0;
+		if (!ozToy::AST::Root::compileStreaming(&scanner, mBuilder, std::cerr, &peakBytes)) {
+			std::cout << "Compilation failed!" << std::endl;
+			return 1;
+		}
+		std::cout << "HIR generation successful!" << std::endl;
+		std::cout << "AST: at most " << peakBytes << " bytes at once" << std::endl;
+		std::cout << "Unresolved names: " << tu.resolveNames() << std::endl;
+		std::cout << "Type conflicts: " << ozToy::HIR::TypeInference(&tu).run() << std::endl;
+		std::cout << "Constants: " << tu.getConstants().getLiterals().size() << std::endl;
+		tu.print(std::cout);
+		return 0;
+	}
+
 	ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
 
-	if(root != nullptr)
+	if(root != nullptr) {
 		std::cout << "Parsing successful!" << std::endl;
-	else
+		const ozToy::Arena& arena = root->getArena();
+		std::cout << "AST: " << arena.getAllocationCount() << " allocations, " << arena.getBytesAllocated() << " bytes" << std::endl;
+	}
+	else {
 		std::cout << "Parsing failed!" << std::endl;
+		return 1;
+	}
 
 	ozToy::HIR::TranslationUnit tu;
 	ozToy::HIR::ModuleBuilder mBuilder(tu.getRootModule());
 
-	root->generateHIR(mBuilder);
+	if (!root->generateHIR(mBuilder)) {
+		std::cout << "HIR generation failed!" << std::endl;
+		return 1;
+	}
 
 	std::cout << "HIR generation successful!" << std::endl;
+	std::cout << "Unresolved names: " << tu.resolveNames() << std::endl;
+	std::cout << "Type conflicts: " << ozToy::HIR::TypeInference(&tu).run() << std::endl;
+	std::cout << "Constants: " << tu.getConstants().getLiterals().size() << std::endl;
 
 	tu.print(std::cout);
 
@@ -0,0 +1,69 @@
+// Root::parse and teardown time on a 1M-statement program, with the arena's and operator new's counts.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api ArenaBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+// Usage: ArenaBench [statements, default 1000000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "AST.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+
+namespace {
+	const int repetitions = 3;
+	std::size_t newCalls = 0;
+	std::size_t newBytes = 0;
+
+	double secondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+// Counts every heap allocation the parse makes outside the arena
+void* operator new(std::size_t size)
+{
+	++newCalls;
+	newBytes += size;
+	void* memory = std::malloc(size);
+	if (memory == nullptr)
+		std::abort();
+	return memory;
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+int main(int argc, char** argv) {
+	std::size_t statements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString(ozToy::Bench::generateProgram(statements));
+	std::printf("%zu statements, %.1f MB, best of %d\n", statements, source->getSize() / 1e6, repetitions);
+
+	double parse = 1e9, teardown = 1e9;
+	for (int r = 0; r < repetitions; ++r) {
+		ozToy::Scanner scanner(source);
+		std::size_t calls = newCalls, bytes = newBytes;
+		auto start = std::chrono::steady_clock::now();
+		ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
+		double seconds = secondsSince(start);
+		if (root == nullptr)
+			return 1;
+		if (seconds < parse)
+			parse = seconds;
+		if (r == 0) {
+			const ozToy::Arena& arena = root->getArena();
+			std::printf("operator new  %zu calls, %.1f MB\n", newCalls - calls, (newBytes - bytes) / 1e6);
+			std::printf("arena         %zu allocations, %.1f MB in %.1f MB of chunks\n", arena.getAllocationCount(),
+				arena.getBytesAllocated() / 1e6, arena.getBytesReserved() / 1e6);
+		}
+
+		start = std::chrono::steady_clock::now();
+		delete root;
+		seconds = secondsSince(start);
+		if (seconds < teardown)
+			teardown = seconds;
+	}
+	std::printf("parse         %.1f ms\nteardown      %.2f ms\n", parse * 1e3, teardown * 1e3);
+	delete source;
+	return 0;
+}
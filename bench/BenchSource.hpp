@@ -0,0 +1,83 @@
+#pragma once
+
+#include <random>
+#include <string>
+
+// Generated programs for the benchmarks that parse; the same seed gives the same text.
+namespace ozToy {
+	namespace Bench {
+
+		inline std::string generateExpression(std::mt19937& rng, int depth)
+		{
+			static const char* const names[] = { "a", "b", "x", "y", "alpha", "counter", "some_longer_identifier_name" };
+			static const char* const operators[] = { " + ", " - ", " * ", " / ", " % ", " << ", " >> ", " < ", " <= ", " == ", " & ", " | ", " ^ ", " && ", " || " };
+			std::string left;
+			switch (depth > 0 ? rng() % 6 : rng() % 3) {
+			case 0:
+				left = names[rng() % 7];
+				break;
+			case 1:
+				left = std::to_string(rng() % 100000);
+				break;
+			case 2:
+				left = rng() % 2 ? "\"hello world\"" : "1.5";
+				break;
+			case 3:
+				left = "(" + generateExpression(rng, depth - 1) + ")";
+				break;
+			case 4:
+				left = "f(" + generateExpression(rng, depth - 1) + ", " + names[rng() % 7] + ")";
+				break;
+			default:
+				left = std::string(rng() % 2 ? "-" : "!") + names[rng() % 7];
+			}
+			if (depth == 0 || rng() % 3 == 0)
+				return left;
+			return left + operators[rng() % 15] + generateExpression(rng, depth - 1);
+		}
+
+		// statementCount statements in functions of up to 40 statements, a module around every
+		// 32 functions and, inside that, one nested module around every 8.
+		inline std::string generateProgram(std::size_t statementCount, unsigned seed = 1)
+		{
+			std::mt19937 rng(seed);
+			std::string source;
+			source.reserve(statementCount * 48);
+			std::size_t function = 0;
+			for (std::size_t statement = 0; statement < statementCount; ++function) {
+				if (function % 32 == 0)
+					source += "module m" + std::to_string(function) + " {\n";
+				if (function % 8 == 4)
+					source += "module inner {\n";
+				source += "fn func" + std::to_string(function) + "(a : int, b : int) -> int {\n";
+				std::size_t length = 1 + rng() % 40;
+				for (std::size_t i = 0; i < length && statement < statementCount; ++i, ++statement) {
+					std::string name = "v" + std::to_string(i);
+					switch (rng() % 4) {
+					case 0:
+						source += "    let " + name + " = " + generateExpression(rng, 3) + ";\n";
+						break;
+					case 1:
+						source += "    var " + name + " : int = " + generateExpression(rng, 3) + ";\n";
+						break;
+					case 2:
+						source += "    x = " + generateExpression(rng, 3) + ";\n";
+						break;
+					default:
+						source += "    y += " + generateExpression(rng, 2) + ";\n";
+					}
+				}
+				source += "}\n";
+				if (function % 8 == 7)
+					source += "}\n";
+				if (function % 32 == 31)
+					source += "}\n";
+			}
+			if (function % 8 >= 5)
+				source += "}\n";
+			if (function % 32 != 0)
+				source += "}\n";
+			return source;
+		}
+	}
+}
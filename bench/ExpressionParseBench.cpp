@@ -0,0 +1,95 @@
+// Root::parse time and operator new calls on deeply nested, long flat and mixed expressions.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api ExpressionParseBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include "AST.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+
+namespace {
+	const int repetitions = 5;
+	const int functions = 200;
+	std::size_t newCalls = 0;
+
+	// Parentheses nested depth deep around a binary operator at every level
+	std::string generateNested(int depth)
+	{
+		std::string source;
+		for (int f = 0; f < functions; ++f) {
+			source += "fn nested" + std::to_string(f) + "(a : int) -> int {\n    let x = ";
+			for (int i = 0; i < depth; ++i)
+				source += "a + (";
+			source += "a";
+			source += std::string(depth, ')');
+			source += ";\n}\n";
+		}
+		return source;
+	}
+
+	// One statement of length operators with mixed priorities
+	std::string generateChains(int length)
+	{
+		static const char* const operators[] = { " + ", " * ", " - ", " << ", " < ", " == ", " & ", " | ", " / " };
+		std::string source;
+		for (int f = 0; f < functions; ++f) {
+			source += "fn chain" + std::to_string(f) + "(a : int) -> int {\n    let x = a";
+			for (int i = 0; i < length; ++i) {
+				source += operators[(i * 7 + f) % 9];
+				source += i % 2 ? "a" : "42";
+			}
+			source += ";\n}\n";
+		}
+		return source;
+	}
+
+	void measure(const char* name, const std::string& text)
+	{
+		ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString(text);
+		double best = 1e9;
+		std::size_t calls = 0;
+		for (int r = 0; r < repetitions; ++r) {
+			ozToy::Scanner scanner(source);
+			std::ostringstream diagnostics;
+			std::size_t before = newCalls;
+			auto start = std::chrono::steady_clock::now();
+			ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner, diagnostics);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			calls = newCalls - before;
+			if (root == nullptr) {
+				std::printf("%-8s does not parse: %s", name, diagnostics.str().c_str());
+				delete source;
+				return;
+			}
+			if (seconds < best)
+				best = seconds;
+			delete root;
+		}
+		std::printf("%-8s %6.1f MB  %8.1f ms  %9zu operator new calls\n", name, text.size() / 1e6, best * 1e3, calls);
+		delete source;
+	}
+}
+
+// Counts the heap allocations made while parsing
+void* operator new(std::size_t size)
+{
+	++newCalls;
+	void* memory = std::malloc(size);
+	if (memory == nullptr)
+		std::abort();
+	return memory;
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+int main() {
+	std::printf("%d functions each, best of %d\n", functions, repetitions);
+	measure("nested", generateNested(2000));
+	measure("chains", generateChains(20000));
+	measure("mixed", ozToy::Bench::generateProgram(400000));
+	return 0;
+}
@@ -0,0 +1,68 @@
+// TypeInference::run time on single functions of long let chains, and on a generated program.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api InferenceBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "AST.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+#include "TypeInference.hpp"
+
+namespace {
+	const int repetitions = 5;
+
+	// Each binding is inferred from the one before; typed vars, literals and assignments join the chain
+	std::string generateLetChain(int count)
+	{
+		std::string source = "fn chain(a : int) -> int {\n    let x0 = a;\n";
+		for (int i = 1; i < count; ++i) {
+			std::string name = "x" + std::to_string(i);
+			source += "    let " + name + " = x" + std::to_string(i - 1) + ";\n";
+			if (i % 3 == 1)
+				source += "    var y" + std::to_string(i) + " : int = " + name + ";\n";
+			else if (i % 3 == 2)
+				source += "    let s" + std::to_string(i) + " = 5;\n    " + name + " = s" + std::to_string(i) + ";\n";
+		}
+		source += "    x" + std::to_string(count - 1) + "\n}\n";
+		return source;
+	}
+
+	void measure(const std::string& name, const std::string& text)
+	{
+		ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString(text);
+		ozToy::Scanner scanner(source);
+		ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
+		if (root == nullptr) {
+			delete source;
+			return;
+		}
+		ozToy::HIR::TranslationUnit tu;
+		ozToy::HIR::ModuleBuilder builder(tu.getRootModule());
+		root->generateHIR(builder);
+		tu.resolveNames(1);
+
+		double best = 1e9;
+		std::size_t conflicts = 0;
+		for (int r = 0; r < repetitions; ++r) {
+			ozToy::HIR::TypeInference inference(&tu);
+			auto start = std::chrono::steady_clock::now();
+			conflicts = inference.run();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		std::printf("%-18s %9.2f ms  %zu conflicts\n", name.c_str(), best * 1e3, conflicts);
+		delete root;
+		delete source;
+	}
+}
+
+int main() {
+	std::printf("best of %d\n", repetitions);
+	const int chainLengths[] = { 10000, 40000, 80000, 160000 };
+	for (int length : chainLengths)
+		measure(std::to_string(length) + " lets", generateLetChain(length));
+	measure("500k statements", ozToy::Bench::generateProgram(500000));
+	return 0;
+}
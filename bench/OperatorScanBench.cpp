@@ -0,0 +1,72 @@
+// Scanner throughput on operator-dense and on mixed generated input, in MB/s and ns per token.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api OperatorScanBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include "Scanner.hpp"
+#include "SourceBuffer.hpp"
+
+namespace {
+	const std::size_t corpusBytes = 16u << 20;
+	const int repetitions = 7;
+
+	// Every punctuator, one per token
+	std::string generateOperators()
+	{
+		static const char* const operators[] = {
+			"+", "-", "*", "/", "%", "^", "&", "|", "~", "!", "?", ":", "=", "<", ">", ".", ",", ";",
+			"(", ")", "{", "}", "[", "]", "&&", "||", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+			":=", "++", "--", "<<", ">>", "<=", ">=", "<<=", ">>=", "==", "!=", "->",
+		};
+		std::mt19937 rng(1);
+		std::string corpus;
+		while (corpus.size() < corpusBytes) {
+			const char* op = operators[rng() % (sizeof(operators) / sizeof(operators[0]))];
+			corpus += op;
+			corpus += rng() % 8 == 0 ? '\n' : ' ';
+		}
+		return corpus;
+	}
+
+	std::string generateStatements()
+	{
+		std::mt19937 rng(2);
+		std::string corpus;
+		while (corpus.size() < corpusBytes) {
+			std::string name = "v" + std::to_string(rng() % 500);
+			corpus += "let " + name + " = " + name + " + 0x1F * (b << 2) - c[i] / 3.5;\n";
+			corpus += name + " += f(a, b) && !d || e >= 7;\n";
+		}
+		return corpus;
+	}
+
+	// Best of several full scans; the source is mapped once, outside the timing
+	void measure(const char* name, const std::string& text)
+	{
+		ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString(text);
+		double best = 1e9;
+		std::size_t tokens = 0;
+		for (int r = 0; r < repetitions; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			ozToy::Scanner scanner(source);
+			tokens = 0;
+			while (scanner.getToken().type != ozToy::TokenType::END_OF_FILE)
+				++tokens;
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		std::printf("%-10s %8zu tokens  %7.1f ms  %6.1f MB/s  %5.1f ns/token\n", name, tokens, best * 1e3,
+			text.size() / best / 1e6, best * 1e9 / tokens);
+		delete source;
+	}
+}
+
+int main() {
+	std::printf("%zu MB per corpus, best of %d\n", corpusBytes >> 20, repetitions);
+	measure("operators", generateOperators());
+	measure("statements", generateStatements());
+	return 0;
+}
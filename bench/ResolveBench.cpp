@@ -0,0 +1,69 @@
+// TranslationUnit::resolveNames throughput on a generated program, for several thread counts.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api ResolveBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+// Usage: ResolveBench [statements, default 500000]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "AST.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+
+namespace {
+	const int repetitions = 3;
+
+	// Names still unresolved, one per line of print
+	std::size_t countUnresolved(ozToy::HIR::TranslationUnit& tu)
+	{
+		std::ostringstream out;
+		tu.print(out);
+		std::string names = out.str();
+		return std::count(names.begin(), names.end(), '\n');
+	}
+}
+
+int main(int argc, char** argv) {
+	std::size_t statements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+	// Declared at the root, so the generated calls to f resolve by walking out of every module
+	ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString("fn f(a : int, b : int) -> int { a }\n" + ozToy::Bench::generateProgram(statements));
+	ozToy::Scanner scanner(source);
+	ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
+	if (root == nullptr)
+		return 1;
+
+	std::size_t references = 0, left = 0;
+	{
+		ozToy::HIR::TranslationUnit tu;
+		ozToy::HIR::ModuleBuilder builder(tu.getRootModule());
+		root->generateHIR(builder);
+		references = countUnresolved(tu);
+		left = tu.resolveNames(1);
+	}
+	std::printf("%zu statements, %zu references, %zu left unresolved, %u hardware threads, best of %d\n", statements,
+		references, left, std::thread::hardware_concurrency(), repetitions);
+
+	const std::size_t threadCounts[] = { 1, 2, 4, 8 };
+	for (std::size_t threadCount : threadCounts) {
+		double best = 1e9;
+		for (int r = 0; r < repetitions; ++r) {
+			// Resolving binds the names, so every run lowers a fresh unit
+			ozToy::HIR::TranslationUnit tu;
+			ozToy::HIR::ModuleBuilder builder(tu.getRootModule());
+			root->generateHIR(builder);
+			auto start = std::chrono::steady_clock::now();
+			tu.resolveNames(threadCount);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		std::printf("%zu threads  %7.1f ms  %6.2f M references/s\n", threadCount, best * 1e3, references / best / 1e6);
+	}
+
+	delete root;
+	delete source;
+	return 0;
+}
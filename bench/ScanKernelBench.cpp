@@ -0,0 +1,98 @@
+// Throughput of the Scanner's character-run kernels, in MB/s, for every implementation the CPU supports.
+// Standalone; build it next to the api sources, e.g.
+//   cl /O2 /std:c++17 /EHs-c- /GR- /I..\api ScanKernelBench.cpp ..\api\ScanKernels.cpp
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -I../api ScanKernelBench.cpp ../api/ScanKernels.cpp
+// Usage: ScanKernelBench [mean run length, default 16]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "ScanKernels.hpp"
+
+namespace {
+	const std::size_t corpusBytes = 64u << 20;
+	const int repetitions = 5;
+
+	// Best of several passes over the buffer; skip is called from every position right after a terminator.
+	template <class Skip>
+	double measure(const std::string& buffer, Skip skip)
+	{
+		double best = 1e9;
+		std::size_t runs = 0;
+		for (int r = 0; r < repetitions; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			const char* cursor = buffer.data();
+			const char* end = cursor + buffer.size();
+			while (cursor < end) {
+				cursor = skip(cursor, end) + 1;
+				++runs;
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		// keeps the loop observable
+		if (runs == 0)
+			std::puts("");
+		return buffer.size() / best / 1e6;
+	}
+
+	double measureLineStarts(const std::string& buffer, const ozToy::ScanKernels* kernels)
+	{
+		double best = 1e9;
+		std::vector<std::uint32_t> lineStarts;
+		for (int r = 0; r < repetitions; ++r) {
+			lineStarts.clear();
+			auto start = std::chrono::steady_clock::now();
+			kernels->findLineStarts(buffer.data(), buffer.data() + buffer.size(), 0, lineStarts);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		return buffer.size() / best / 1e6;
+	}
+}
+
+int main(int argc, char** argv) {
+	int runLength = argc > 1 ? std::atoi(argv[1]) : 16;
+	if (runLength < 1)
+		runLength = 1;
+
+	// One corpus per kernel: runs of matching bytes of random length, each closed by a byte that stops the kernel.
+	std::mt19937 rng(1);
+	std::string whitespace, identifiers, digits, strings;
+	while (whitespace.size() < corpusBytes) {
+		int length = 1 + static_cast<int>(rng() % (2 * runLength));
+		for (int i = 0; i < length; ++i) {
+			whitespace += " \t\n\r"[rng() % 4];
+			identifiers += "abcXYZ_019"[rng() % 10];
+			digits += "0123456789"[rng() % 10];
+			strings += "abc def"[rng() % 7];
+		}
+		whitespace += 'x';
+		identifiers += ' ';
+		digits += ' ';
+		strings += '"';
+	}
+
+	const ozToy::ScanKernels* implementations[] = {
+		ozToy::getScalarScanKernels(),
+		ozToy::getSse2ScanKernels(),
+		ozToy::getAvx2ScanKernels(),
+	};
+	std::printf("mean run length %d, %zu MB per corpus\n", runLength, corpusBytes >> 20);
+	for (const ozToy::ScanKernels* kernels : implementations) {
+		if (kernels == nullptr)
+			continue;
+		std::printf("%-7s whitespace %7.0f  identifier %7.0f  digits %7.0f  string %7.0f  lines %7.0f MB/s\n", kernels->name,
+			measure(whitespace, kernels->skipWhitespace),
+			measure(identifiers, kernels->skipIdentifier),
+			measure(digits, kernels->skipDigits),
+			measure(strings, [kernels](const char* begin, const char* end) { return kernels->skipStringBody(begin, end, '"'); }),
+			measureLineStarts(whitespace, kernels));
+	}
+	return 0;
+}
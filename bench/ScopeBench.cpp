@@ -0,0 +1,79 @@
+// FunctionBuilder time and heap allocations for deeply nested blocks, each looking up an outer and the latest name.
+// Built directly on FunctionBuilder, since in the grammar only function bodies become blocks.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api ScopeBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "HIRBuilder.hpp"
+#include "SymbolTable.hpp"
+
+namespace {
+	const int repetitions = 3;
+	std::size_t newCalls = 0;
+
+	// functions functions of depth nested blocks; every declareEvery-th block declares a name
+	void measure(int depth, int declareEvery, int functions)
+	{
+		ozToy::SymbolTable* symbols = ozToy::SymbolTable::getInstance();
+		std::vector<ozToy::SymbolId> names;
+		for (int d = 0; d <= depth; ++d)
+			names.push_back(symbols->intern("v" + std::to_string(d)));
+
+		double best = 1e9;
+		std::size_t allocations = 0;
+		for (int r = 0; r < repetitions; ++r) {
+			ozToy::HIR::TranslationUnit tu;
+			ozToy::HIR::ModuleBuilder module(tu.getRootModule());
+			std::size_t before = newCalls;
+			auto start = std::chrono::steady_clock::now();
+			for (int f = 0; f < functions; ++f) {
+				ozToy::HIR::FunctionBuilder builder(module.getModule().createFunction("f" + std::to_string(f)));
+				builder.createBlock();
+				builder.declVariable(names[0], false);
+				int latest = 0;
+				for (int d = 1; d <= depth; ++d) {
+					builder.createBlock();
+					if (d % declareEvery == 0) {
+						builder.declVariable(names[d], false);
+						latest = d;
+					}
+					builder.addInstruction(builder.getVariable(names[0]));
+					builder.addInstruction(builder.getVariable(names[latest]));
+				}
+				for (int d = 0; d <= depth; ++d)
+					builder.exitBlock();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best) {
+				best = seconds;
+				allocations = newCalls - before;
+			}
+		}
+		std::printf("depth %5d  declare every %3d  x%-5d %9.1f ms  %9zu allocations\n", depth, declareEvery, functions, best * 1e3, allocations);
+	}
+}
+
+// Counts the heap allocations made while building
+void* operator new(std::size_t size)
+{
+	++newCalls;
+	void* memory = std::malloc(size);
+	if (memory == nullptr)
+		std::abort();
+	return memory;
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+int main() {
+	std::printf("best of %d\n", repetitions);
+	measure(100, 1, 1000);
+	measure(1000, 4, 100);
+	measure(10000, 2, 10);
+	measure(10000, 100, 10);
+	return 0;
+}
@@ -0,0 +1,65 @@
+// Most AST bytes held at once, and time, for parsing and lowering a generated program whole against
+// compileStreaming. Run one mode per process to compare their peak memory with an external tool.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api StreamingBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+// Usage: StreamingBench [whole|stream|both, default both] [functions|single, default functions] [statements, default 1000000]
+// "single" puts every statement in one function, the case streaming cannot bound.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include "AST.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+
+namespace {
+	std::string generateSingleFunction(std::size_t statementCount)
+	{
+		std::mt19937 rng(1);
+		std::string source = "fn single(a : int, b : int) -> int {\n";
+		for (std::size_t i = 0; i < statementCount; ++i)
+			source += "    let v" + std::to_string(i % 1000) + " = " + ozToy::Bench::generateExpression(rng, 3) + ";\n";
+		source += "}\n";
+		return source;
+	}
+
+	void run(ozToy::SourceBuffer* source, bool streaming)
+	{
+		auto start = std::chrono::steady_clock::now();
+		ozToy::Scanner scanner(source);
+		ozToy::HIR::TranslationUnit tu;
+		ozToy::HIR::ModuleBuilder builder(tu.getRootModule());
+		std::size_t peakBytes = 0;
+		if (streaming) {
+			if (!ozToy::AST::Root::compileStreaming(&scanner, builder, std::cerr, &peakBytes))
+				std::exit(1);
+		}
+		else {
+			ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
+			if (root == nullptr)
+				std::exit(1);
+			peakBytes = root->getArena().getBytesAllocated();
+			root->generateHIR(builder);
+			delete root;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("%-6s  AST peak %9.2f MB  %8.1f ms\n", streaming ? "stream" : "whole", peakBytes / 1e6, seconds * 1e3);
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* mode = argc > 1 ? argv[1] : "both";
+	bool single = argc > 2 && std::strcmp(argv[2], "single") == 0;
+	std::size_t statements = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+	ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString(single ? generateSingleFunction(statements) : ozToy::Bench::generateProgram(statements));
+	std::printf("%zu statements in %s, %.1f MB\n", statements, single ? "one function" : "functions of up to 40", source->getSize() / 1e6);
+
+	if (std::strcmp(mode, "stream") != 0)
+		run(source, false);
+	if (std::strcmp(mode, "whole") != 0)
+		run(source, true);
+	delete source;
+	return 0;
+}
@@ -0,0 +1,61 @@
+// Root::parse time with the Scanner on the parsing thread against a TokenPipe scanning on its own thread.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api TokenPipeBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+// Usage: TokenPipeBench [statements, default 500000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "AST.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+#include "TokenPipe.hpp"
+
+namespace {
+	const int repetitions = 5;
+
+	double secondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv) {
+	std::size_t statements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+	ozToy::SourceBuffer* source = ozToy::SourceBuffer::fromString(ozToy::Bench::generateProgram(statements));
+	std::printf("%zu statements, %.1f MB, %u hardware threads, best of %d\n", statements, source->getSize() / 1e6,
+		std::thread::hardware_concurrency(), repetitions);
+
+	// Alternated, so both modes see the same machine state
+	double direct = 1e9, pipelined = 1e9;
+	for (int r = 0; r < repetitions; ++r) {
+		{
+			ozToy::SymbolTable symbols;
+			auto start = std::chrono::steady_clock::now();
+			ozToy::Scanner scanner(source, &symbols);
+			ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
+			double seconds = secondsSince(start);
+			if (root == nullptr)
+				return 1;
+			if (seconds < direct)
+				direct = seconds;
+			delete root;
+		}
+		{
+			ozToy::SymbolTable symbols;
+			auto start = std::chrono::steady_clock::now();
+			ozToy::TokenPipe pipe(source, &symbols);
+			ozToy::Scanner scanner(&pipe);
+			ozToy::AST::Root* root = ozToy::AST::Root::parse(&scanner);
+			double seconds = secondsSince(start);
+			if (root == nullptr)
+				return 1;
+			if (seconds < pipelined)
+				pipelined = seconds;
+			delete root;
+		}
+	}
+	std::printf("direct    %7.1f ms\npipelined %7.1f ms  (%.2fx)\n", direct * 1e3, pipelined * 1e3, direct / pipelined);
+	delete source;
+	return 0;
+}
@@ -0,0 +1,221 @@
+// Per-node cost of a kind-switch visitor against virtual calls, both counting the nodes of one parsed program,
+// plus the time of the two real passes on the visitors, generateHIR and flatten.
+// The virtual side walks a mirror of the AST with one class, and so one vtable, per node class.
+// Standalone; build it with every api source except main.cpp, e.g.
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api VisitorDispatchBench.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+// Usage: VisitorDispatchBench [statements, default 500000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "AST.hpp"
+#include "ASTVisitor.hpp"
+#include "BenchSource.hpp"
+#include "SourceBuffer.hpp"
+
+using namespace ozToy;
+using namespace ozToy::AST;
+
+namespace {
+	const int repetitions = 20;
+
+	struct VirtualNode {
+		virtual std::size_t countNodes() const = 0;
+	};
+
+	// Fills a mirror node out to the size the AST node had with a vptr, so both walks touch as much memory
+	template <std::size_t Size>
+	struct Padding {
+		unsigned char bytes[Size];
+	};
+	template <>
+	struct Padding<0> {};
+
+	template <typename Original, std::size_t ChildBytes>
+	using PaddingFor = Padding<sizeof(Original) + sizeof(void*) - sizeof(VirtualNode) - ChildBytes>;
+
+	template <typename Original>
+	struct VirtualLeaf final : VirtualNode {
+		PaddingFor<Original, 0> padding;
+		std::size_t countNodes() const override { return 1; }
+	};
+
+	template <typename Original>
+	struct VirtualUnary final : VirtualNode {
+		const VirtualNode* child;
+		PaddingFor<Original, sizeof(child)> padding;
+		explicit VirtualUnary(const VirtualNode* child) : child(child) {}
+		std::size_t countNodes() const override { return 1 + child->countNodes(); }
+	};
+
+	template <typename Original>
+	struct VirtualBinary final : VirtualNode {
+		const VirtualNode* left;
+		const VirtualNode* right;
+		PaddingFor<Original, sizeof(left) + sizeof(right)> padding;
+		VirtualBinary(const VirtualNode* left, const VirtualNode* right) : left(left), right(right) {}
+		std::size_t countNodes() const override { return 1 + left->countNodes() + right->countNodes(); }
+	};
+
+	template <typename Original>
+	struct VirtualList final : VirtualNode {
+		ArenaSpan<const VirtualNode*> children;
+		PaddingFor<Original, sizeof(children)> padding;
+		explicit VirtualList(ArenaSpan<const VirtualNode*> children) : children(children) {}
+		std::size_t countNodes() const override
+		{
+			std::size_t count = 1;
+			for (const VirtualNode* child : children)
+				count += child->countNodes();
+			return count;
+		}
+	};
+
+	class Counter : public TopLevelVisitor<Counter, std::size_t>, public ExpressionVisitor<Counter, std::size_t>
+	{
+	public:
+		using TopLevelVisitor<Counter, std::size_t>::visit;
+		using ExpressionVisitor<Counter, std::size_t>::visit;
+
+		std::size_t visitModule(const Module* node)
+		{
+			std::size_t count = 1;
+			for (const TopLevel* item : node->getTopLevel())
+				count += visit(item);
+			return count;
+		}
+		std::size_t visitFunction(const DeclarationFunction* node) { return 1 + node->getArguments().size + visit(node->getBody()); }
+		std::size_t visitDeclarationVariable(const DeclarationVariable*) { return 1; }
+		std::size_t visitBlock(const BlockExpression* node) { return 1 + visit(node->getInner()); }
+		std::size_t visitSequence(const SequenceExpression* node)
+		{
+			std::size_t count = 1;
+			for (const Expression* statement : node->getStatements())
+				count += visit(statement);
+			return count;
+		}
+		std::size_t visitNumber(const NumberExpression*) { return 1; }
+		std::size_t visitString(const StringExpression*) { return 1; }
+		std::size_t visitChar(const CharExpression*) { return 1; }
+		std::size_t visitIdentifier(const IdentifierExpression*) { return 1; }
+		std::size_t visitBinary(const BinaryExpression* node) { return 1 + visit(node->getLeft()) + visit(node->getRight()); }
+		std::size_t visitUnary(const UnaryExpression* node) { return 1 + visit(node->getOperand()); }
+		std::size_t visitCall(const CallExpression* node)
+		{
+			std::size_t count = 1 + visit(node->getCallee());
+			for (const Expression* argument : node->getArguments())
+				count += visit(argument);
+			return count;
+		}
+		std::size_t visitIndex(const IndexExpression* node) { return 1 + visit(node->getTarget()) + visit(node->getIndex()); }
+		std::size_t visitNop(const NOPExpression*) { return 1; }
+	};
+
+	// Builds the virtual mirror in the same depth-first order the AST was allocated in
+	class Mirror : public TopLevelVisitor<Mirror, const VirtualNode*>, public ExpressionVisitor<Mirror, const VirtualNode*>
+	{
+		Arena& arena;
+
+		template <typename Items>
+		ArenaSpan<const VirtualNode*> mirrorAll(const VirtualNode* first, const Items& items)
+		{
+			std::vector<const VirtualNode*> children;
+			if (first != nullptr)
+				children.push_back(first);
+			for (auto item : items)
+				children.push_back(visit(item));
+			return arena.copy(children);
+		}
+	public:
+		using TopLevelVisitor<Mirror, const VirtualNode*>::visit;
+		using ExpressionVisitor<Mirror, const VirtualNode*>::visit;
+		explicit Mirror(Arena& arena) : arena(arena) {}
+
+		const VirtualNode* visitModule(const Module* node) { return arena.create<VirtualList<Module>>(mirrorAll(nullptr, node->getTopLevel())); }
+		const VirtualNode* visitFunction(const DeclarationFunction* node)
+		{
+			std::vector<const VirtualNode*> children;
+			for (std::size_t i = 0; i < node->getArguments().size; ++i)
+				children.push_back(arena.create<VirtualLeaf<Argument>>());
+			children.push_back(visit(node->getBody()));
+			return arena.create<VirtualList<DeclarationFunction>>(arena.copy(children));
+		}
+		const VirtualNode* visitDeclarationVariable(const DeclarationVariable*) { return arena.create<VirtualLeaf<DeclarationVariable>>(); }
+		const VirtualNode* visitBlock(const BlockExpression* node) { return arena.create<VirtualUnary<BlockExpression>>(visit(node->getInner())); }
+		const VirtualNode* visitSequence(const SequenceExpression* node) { return arena.create<VirtualList<SequenceExpression>>(mirrorAll(nullptr, node->getStatements())); }
+		const VirtualNode* visitNumber(const NumberExpression*) { return arena.create<VirtualLeaf<NumberExpression>>(); }
+		const VirtualNode* visitString(const StringExpression*) { return arena.create<VirtualLeaf<StringExpression>>(); }
+		const VirtualNode* visitChar(const CharExpression*) { return arena.create<VirtualLeaf<CharExpression>>(); }
+		const VirtualNode* visitIdentifier(const IdentifierExpression*) { return arena.create<VirtualLeaf<IdentifierExpression>>(); }
+		const VirtualNode* visitBinary(const BinaryExpression* node)
+		{
+			const VirtualNode* left = visit(node->getLeft());
+			return arena.create<VirtualBinary<BinaryExpression>>(left, visit(node->getRight()));
+		}
+		const VirtualNode* visitUnary(const UnaryExpression* node) { return arena.create<VirtualUnary<UnaryExpression>>(visit(node->getOperand())); }
+		const VirtualNode* visitCall(const CallExpression* node) { return arena.create<VirtualList<CallExpression>>(mirrorAll(visit(node->getCallee()), node->getArguments())); }
+		const VirtualNode* visitIndex(const IndexExpression* node)
+		{
+			const VirtualNode* target = visit(node->getTarget());
+			return arena.create<VirtualBinary<IndexExpression>>(target, visit(node->getIndex()));
+		}
+		const VirtualNode* visitNop(const NOPExpression*) { return arena.create<VirtualLeaf<NOPExpression>>(); }
+	};
+
+	template <typename Pass>
+	double bestOf(int runs, Pass pass)
+	{
+		double best = 1e9;
+		for (int r = 0; r < runs; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			pass();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::size_t statements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+	SourceBuffer* source = SourceBuffer::fromString(Bench::generateProgram(statements));
+	Scanner scanner(source);
+	Root* root = Root::parse(&scanner);
+	if (root == nullptr)
+		return 1;
+
+	Arena mirrorArena;
+	Mirror mirror(mirrorArena);
+	std::vector<const VirtualNode*> mirrorTopLevel;
+	for (const TopLevel* item : root->getTopLevel())
+		mirrorTopLevel.push_back(mirror.visit(item));
+
+	// The sums are printed so neither walk can be optimized away
+	std::size_t visited = 0, called = 0;
+	double visitorSeconds = bestOf(repetitions, [&] {
+		Counter counter;
+		visited = 0;
+		for (const TopLevel* item : root->getTopLevel())
+			visited += counter.visit(item);
+	});
+	double virtualSeconds = bestOf(repetitions, [&] {
+		called = 0;
+		for (const VirtualNode* item : mirrorTopLevel)
+			called += item->countNodes();
+	});
+	std::printf("%zu statements, %zu nodes (%zu mirrored), best of %d\n", statements, visited, called, repetitions);
+	std::printf("virtual calls  %6.2f ns/node\nvisitor        %6.2f ns/node\n", virtualSeconds * 1e9 / called, visitorSeconds * 1e9 / visited);
+
+	double lowerSeconds = bestOf(5, [&] {
+		HIR::TranslationUnit tu;
+		HIR::ModuleBuilder builder(tu.getRootModule());
+		root->generateHIR(builder);
+	});
+	double flattenSeconds = bestOf(5, [&] { delete FlatTree::flatten(root); });
+	std::printf("generateHIR    %6.1f ms\nflatten        %6.1f ms\n", lowerSeconds * 1e3, flattenSeconds * 1e3);
+
+	delete root;
+	delete source;
+	return 0;
+}
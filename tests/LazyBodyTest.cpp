@@ -0,0 +1,47 @@
+#include <iostream>
+#include <sstream>
+#include "Tests.hpp"
+#include "AST.hpp"
+#include "SourceBuffer.hpp"
+#include "TokenStream.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		// A lazy body is only parsed when it is lowered, so its syntax error has to come back from
+		// generateHIR and flatten rather than leave an empty function behind.
+		bool lazyBodyFailureIsReported()
+		{
+			SourceBuffer* source = SourceBuffer::fromString("fn f(a : int) -> int { a }\nfn g() -> int { let = 3 }\n");
+			TokenStream* stream = TokenStream::lex(source);
+			Scanner scanner(stream);
+			std::ostringstream diagnostics;
+			AST::Root* root = AST::Root::parse(&scanner, diagnostics, AST::BodyParsing::LAZY);
+
+			bool passed = true;
+			if (root == nullptr) {
+				std::cout << "the bodies were parsed eagerly" << std::endl;
+				passed = false;
+			}
+			else {
+				HIR::TranslationUnit tu;
+				HIR::ModuleBuilder builder(tu.getRootModule());
+				if (root->generateHIR(builder)) {
+					std::cout << "generateHIR succeeded on a body that does not parse" << std::endl;
+					passed = false;
+				}
+				AST::FlatTree* flat = AST::FlatTree::flatten(root);
+				if (flat != nullptr) {
+					std::cout << "flatten succeeded on a body that does not parse" << std::endl;
+					passed = false;
+					delete flat;
+				}
+				delete root;
+			}
+
+			delete stream;
+			delete source;
+			return passed;
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include "Tests.hpp"
+#include "SourceBuffer.hpp"
+#include "SymbolTable.hpp"
+#include "TokenStream.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			// Enough for several 1 MiB chunks, so lexParallel really splits the file
+			const std::size_t CorpusSize = std::size_t(6) << 20;
+		}
+
+		// Statements of every token kind, with a few literals that span lines so that
+		// some chunk cuts land inside a token and have to be repaired while stitching.
+		std::string generateTokenCorpus(std::size_t size)
+		{
+			static const char* const fragments[] = {
+				"let ", "fn ", "if ", "else ", "return ", "while ", " = ", " := ", " += ", " == ", " <= ", " -> ",
+				"(", ")", "{", "}", "[", "]", ", ", "; ", ".", "::", " + ", " * ", " - ", " / ", " % ", " && ", " || ", "!",
+				"0", "42", "0x1F", "0b1011", "1.5", "2.5e+3", "3E-2", "18446744073709551615", "18446744073709551616",
+				"\"text\"", "\"esc\\\"aped\"", "'a'", "'\\n'",
+				"123abc", "0x", "1e+", "'ab'", "@", "\xC3\xA9",
+			};
+			const std::size_t fragmentCount = sizeof(fragments) / sizeof(fragments[0]);
+
+			std::mt19937 random(7);
+			std::string corpus;
+			corpus.reserve(size + 256);
+			while (corpus.size() < size) {
+				std::size_t tokens = 1 + random() % 12;
+				for (std::size_t i = 0; i < tokens; ++i) {
+					if (random() % 3 == 0) {
+						// A few hundred distinct names, so symbol ids repeat across chunks
+						corpus += "name";
+						corpus += std::to_string(random() % 397);
+						corpus += ' ';
+					}
+					else
+						corpus += fragments[random() % fragmentCount];
+				}
+				if (random() % 64 == 0) {
+					corpus += "\"";
+					for (std::size_t line = 0; line < 16; ++line)
+						corpus += "fn let 0x1F 'a' name1 spans\n";
+					corpus += "\"";
+				}
+				corpus += random() % 4 == 0 ? "\r\n" : "\n";
+			}
+			return corpus;
+		}
+
+		bool sameTokens(const TokenStream& expected, const TokenStream& actual, const std::string& context)
+		{
+			if (expected.size() != actual.size()) {
+				std::cout << context << ": " << actual.size() << " tokens, lex produced " << expected.size() << std::endl;
+				return false;
+			}
+			for (std::size_t i = 0; i < expected.size(); ++i) {
+				Token want = expected.get(i);
+				Token got = actual.get(i);
+				bool same = want.type == got.type && want.offset == got.offset && want.text == got.text;
+				if (same && (want.type == TokenType::NUMBER || want.type == TokenType::FLOAT))
+					same = want.number == got.number;
+				else if (same)
+					same = want.symbol == got.symbol;
+				if (!same) {
+					std::cout << context << ": token " << i << " at offset " << got.offset << " differs from lex" << std::endl;
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool lexParallelMatchesLex()
+		{
+			SourceBuffer* source = SourceBuffer::fromString(generateTokenCorpus(CorpusSize));
+			SymbolTable serialSymbols;
+			TokenStream* serial = TokenStream::lex(source, &serialSymbols);
+
+			bool passed = true;
+			const std::size_t threadCounts[] = { 1, 2, 3, 4, 6, 8 };
+			for (std::size_t threadCount : threadCounts) {
+				// A fresh table each time, so ids have to come out in serial order to match
+				SymbolTable parallelSymbols;
+				TokenStream* parallel = TokenStream::lexParallel(source, threadCount, &parallelSymbols);
+				std::string context = std::to_string(threadCount) + " threads";
+				if (!sameTokens(*serial, *parallel, context))
+					passed = false;
+				else if (parallelSymbols.size() != serialSymbols.size()) {
+					std::cout << context << ": " << parallelSymbols.size() << " symbols, lex interned " << serialSymbols.size() << std::endl;
+					passed = false;
+				}
+				delete parallel;
+			}
+
+			delete serial;
+			delete source;
+			return passed;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Tests.hpp"
+#include "AST.hpp"
+#include "SourceBuffer.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			const std::size_t StatementCount = 1000000;
+
+			// One function whose body is StatementCount statements, each using the one before
+			std::string generateBody()
+			{
+				std::string source = "fn main(a : int) -> int {\n";
+				source.reserve(StatementCount * 40);
+				for (std::size_t i = 0; i < StatementCount; ++i) {
+					std::string n = std::to_string(i);
+					std::string previous = std::to_string(i == 0 ? 0 : i - 1);
+					if (i % 2 == 0)
+						source += "\tlet v" + n + " = a + " + n + " * v" + previous;
+					else
+						source += "\tv" + previous + " = -v" + previous;
+					source += i + 1 < StatementCount ? ";\n" : "\n";
+				}
+				source += "}\n";
+				return source;
+			}
+		}
+
+		// A body is one flat SequenceExpression rather than a chain nested once per statement, so
+		// parsing and both lowerings walk it with a loop. With recursion per statement a million
+		// of them would overflow the stack and crash the test.
+		bool longSequenceLowers()
+		{
+			SourceBuffer* source = SourceBuffer::fromString(generateBody());
+			Scanner scanner(source);
+			AST::Root* root = AST::Root::parse(&scanner, std::cout);
+			if (root == nullptr) {
+				std::cout << "the generated body did not parse" << std::endl;
+				delete source;
+				return false;
+			}
+
+			bool passed = true;
+			const AST::Expression* body = nullptr;
+			if (root->getTopLevel().size() == 1 && root->getTopLevel()[0]->getKind() == AST::NodeKind::DECLARATION_FUNCTION) {
+				const AST::BlockExpression* block = static_cast<const AST::DeclarationFunction*>(root->getTopLevel()[0])->getBody();
+				if (block != nullptr)
+					body = block->getInner();
+			}
+			if (body == nullptr || body->getKind() != AST::NodeKind::SEQUENCE || static_cast<const AST::SequenceExpression*>(body)->getStatements().size != StatementCount) {
+				std::cout << "the body is not one sequence of " << StatementCount << " statements" << std::endl;
+				passed = false;
+			}
+
+			std::ostringstream treeHIR;
+			{
+				HIR::TranslationUnit tu;
+				HIR::ModuleBuilder builder(tu.getRootModule());
+				if (!root->generateHIR(builder)) {
+					std::cout << "tree lowering failed" << std::endl;
+					passed = false;
+				}
+				tu.print(treeHIR);
+			}
+
+			AST::FlatTree* flat = AST::FlatTree::flatten(root);
+			delete root;
+			std::ostringstream flatHIR;
+			if (flat != nullptr) {
+				HIR::TranslationUnit tu;
+				HIR::ModuleBuilder builder(tu.getRootModule());
+				flat->generateHIR(builder);
+				tu.print(flatHIR);
+				delete flat;
+			}
+			delete source;
+
+			if (treeHIR.str() != flatHIR.str()) {
+				std::cout << "tree and flat lowering produce different HIR" << std::endl;
+				passed = false;
+			}
+			return passed;
+		}
+	}
+}
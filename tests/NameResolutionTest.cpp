@@ -0,0 +1,79 @@
+#include <iostream>
+#include <string>
+#include "Tests.hpp"
+#include "HIRBuilder.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			// What the type of argument index of function was bound to, or null
+			const HIR::Type* boundType(HIR::FunctionImpl* function, std::size_t index)
+			{
+				auto type = static_cast<HIR::UnresolvedType*>(function->getArguments()[index]->getType());
+				if (type->getStruct() != nullptr)
+					return type->getStruct();
+				if (type->getClass() != nullptr)
+					return type->getClass();
+				return type->getPrimitive();
+			}
+		}
+
+		// A type name resolves to the nearest declaration walking out from the module that names it,
+		// so the same spelling in two modules can be two types.
+		bool nestedTypesResolve()
+		{
+			HIR::TranslationUnit tu;
+			HIR::ModuleImpl* root = tu.getRootModule();
+			HIR::ModuleImpl* outer = root->createModule("outer");
+			HIR::ModuleImpl* inner = outer->createModule("inner");
+			const HIR::Type* rootPoint = root->createStruct("Point");
+			const HIR::Type* innerPoint = inner->createStruct("Point");
+			const HIR::Type* shape = outer->createClass("Shape");
+			const HIR::Type* integer = HIR::PrimitiveType::lookup("int");
+
+			// Every function takes one argument of each of these types
+			const char* const typeNames[] = { "Point", "Shape", "int", "Missing" };
+			HIR::FunctionImpl* f = root->createFunction("f");
+			HIR::FunctionImpl* g = outer->createFunction("g");
+			HIR::FunctionImpl* h = inner->createFunction("h");
+			HIR::FunctionImpl* h2 = inner->createFunction("h2");
+			for (HIR::FunctionImpl* function : { f, g, h, h2 }) {
+				HIR::FunctionBuilder builder(function);
+				for (const char* typeName : typeNames)
+					builder.addArgument(std::string("a") + typeName, typeName);
+			}
+			std::size_t unresolved = tu.resolveNames(1);
+
+			struct Expected {
+				const char* name;
+				HIR::FunctionImpl* function;
+				const HIR::Type* point;
+				const HIR::Type* shape;
+			};
+			const Expected expected[] = {
+				{ "f", f, rootPoint, nullptr },
+				{ "g", g, rootPoint, shape },
+				{ "h", h, innerPoint, shape },
+				{ "h2", h2, innerPoint, shape },
+			};
+			bool passed = true;
+			for (const Expected& e : expected) {
+				if (boundType(e.function, 0) != e.point || boundType(e.function, 1) != e.shape || boundType(e.function, 2) != integer || boundType(e.function, 3) != nullptr) {
+					std::cout << "a type named in " << e.name << " resolved to the wrong declaration" << std::endl;
+					passed = false;
+				}
+			}
+			// Shape from the root module and Missing from each of the three modules
+			if (unresolved != 4) {
+				std::cout << unresolved << " names left unresolved instead of 4" << std::endl;
+				passed = false;
+			}
+			if (h->getArguments()[0]->getType() != h2->getArguments()[0]->getType() || f->getArguments()[0]->getType() == h->getArguments()[0]->getType()) {
+				std::cout << "named types are not interned per module" << std::endl;
+				passed = false;
+			}
+			return passed;
+		}
+	}
+}
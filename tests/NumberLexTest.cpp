@@ -0,0 +1,89 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Tests.hpp"
+#include "Scanner.hpp"
+#include "SourceBuffer.hpp"
+#include "TokenStream.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			// The first token of source; error is the message of an ERROR token
+			struct NumberCase {
+				const char* source;
+				TokenType type;
+				std::uint64_t integer;
+				double real;
+				const char* error;
+			};
+
+			const NumberCase Cases[] = {
+				{ "0", TokenType::NUMBER, 0, 0, nullptr },
+				{ "42", TokenType::NUMBER, 42, 0, nullptr },
+				{ "00000000000000000000000042", TokenType::NUMBER, 42, 0, nullptr },
+				{ "18446744073709551615", TokenType::NUMBER, 18446744073709551615u, 0, nullptr },
+				{ "18446744073709551616", TokenType::ERROR, 0, 0, "Integer literal out of range" },
+				{ "0xFF", TokenType::NUMBER, 0xFF, 0, nullptr },
+				{ "0XdeadBEEF", TokenType::NUMBER, 0xdeadbeef, 0, nullptr },
+				{ "0xffffffffffffffff", TokenType::NUMBER, 0xffffffffffffffffu, 0, nullptr },
+				{ "0x1ffffffffffffffff", TokenType::ERROR, 0, 0, "Integer literal out of range" },
+				{ "0x", TokenType::ERROR, 0, 0, "Expected hexadecimal digits" },
+				{ "0b1011", TokenType::NUMBER, 11, 0, nullptr },
+				{ "0b1111111111111111111111111111111111111111111111111111111111111111", TokenType::NUMBER, 0xffffffffffffffffu, 0, nullptr },
+				{ "0b11111111111111111111111111111111111111111111111111111111111111111", TokenType::ERROR, 0, 0, "Integer literal out of range" },
+				{ "0b", TokenType::ERROR, 0, 0, "Expected binary digits" },
+				{ "0b102", TokenType::ERROR, 0, 0, "Invalid suffix on numeric literal" },
+				{ "123abc", TokenType::ERROR, 0, 0, "Invalid suffix on numeric literal" },
+				{ "12_3", TokenType::ERROR, 0, 0, "Invalid suffix on numeric literal" },
+				{ "1.5", TokenType::FLOAT, 0, 1.5, nullptr },
+				{ "0.1", TokenType::FLOAT, 0, 0.1, nullptr },
+				{ "3e10", TokenType::FLOAT, 0, 3e10, nullptr },
+				{ "3E-2", TokenType::FLOAT, 0, 3E-2, nullptr },
+				{ "2.5e+3", TokenType::FLOAT, 0, 2.5e+3, nullptr },
+				{ "1.7976931348623157e308", TokenType::FLOAT, 0, 1.7976931348623157e308, nullptr },
+				{ "1e999", TokenType::ERROR, 0, 0, "Float literal out of range" },
+				{ "1e-400", TokenType::ERROR, 0, 0, "Float literal out of range" },
+				{ "1e", TokenType::ERROR, 0, 0, "Invalid suffix on numeric literal" },
+				{ "1e+", TokenType::ERROR, 0, 0, "Invalid suffix on numeric literal" },
+				// A dot without a digit after it is member access, not a fraction
+				{ "1.", TokenType::NUMBER, 1, 0, nullptr },
+				{ "1..2", TokenType::NUMBER, 1, 0, nullptr },
+			};
+
+			bool matches(const NumberCase& expected, const Token& token, const char* lexer)
+			{
+				bool same = token.type == expected.type;
+				if (same && expected.type == TokenType::NUMBER)
+					same = token.number == expected.integer;
+				else if (same && expected.type == TokenType::FLOAT)
+					same = floatFromBits(token.number) == expected.real;
+				else if (same)
+					same = token.text == expected.error;
+				if (!same)
+					std::cout << lexer << " lexed \"" << expected.source << "\" as " << TokenTypeToString(token.type) << " " << token.text << std::endl;
+				return same;
+			}
+		}
+
+		// Numbers are converted while lexing, so their values and range errors have to come out
+		// of both the streaming Scanner and TokenStream::lex.
+		bool numbersLexToValues()
+		{
+			bool passed = true;
+			for (const NumberCase& expected : Cases) {
+				std::istringstream input(expected.source);
+				Scanner scanner(&input);
+				passed = matches(expected, scanner.getToken(), "Scanner") && passed;
+
+				SourceBuffer* source = SourceBuffer::fromString(expected.source);
+				TokenStream* stream = TokenStream::lex(source);
+				passed = matches(expected, stream->get(0), "TokenStream") && passed;
+				delete stream;
+				delete source;
+			}
+			return passed;
+		}
+	}
+}
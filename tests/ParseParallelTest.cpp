@@ -0,0 +1,178 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include "Tests.hpp"
+#include "AST.hpp"
+#include "SourceBuffer.hpp"
+#include "TokenStream.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			const std::size_t FunctionCount = 3000;
+
+			std::string generateExpression(std::mt19937& random, std::size_t depth)
+			{
+				static const char* const leaves[] = { "a", "b", "x", "0", "42", "0x1F", "1.5", "\"}{\"", "'}'" };
+				static const char* const binary[] = { " + ", " - ", " * ", " / ", " == ", " < ", " && ", " || ", " & " };
+				static const char* const unary[] = { "- ", "!", "~" };
+				if (depth == 0 || random() % 3 == 0)
+					return leaves[random() % (sizeof(leaves) / sizeof(leaves[0]))];
+				switch (random() % 5) {
+				case 0:
+					return unary[random() % 3] + generateExpression(random, depth - 1);
+				case 1:
+					return "(" + generateExpression(random, depth - 1) + ")";
+				case 2:
+					return "g(" + generateExpression(random, depth - 1) + ", " + generateExpression(random, depth - 1) + ")";
+				case 3:
+					return "a[" + generateExpression(random, depth - 1) + "]";
+				default:
+					return generateExpression(random, depth - 1) + binary[random() % 9] + generateExpression(random, depth - 1);
+				}
+			}
+
+			void generateBody(std::mt19937& random, std::string& out, std::size_t depth)
+			{
+				std::size_t statements = random() % 5;
+				for (std::size_t i = 0; i < statements; ++i) {
+					switch (random() % 4) {
+					case 0:
+						out += "let x = " + generateExpression(random, 3) + ";\n";
+						break;
+					case 1:
+						out += "var y : int = " + generateExpression(random, 3) + ";\n";
+						break;
+					case 2:
+						out += "x = " + generateExpression(random, 3) + ";\n";
+						break;
+					default:
+						if (depth > 0) {
+							out += "{ ";
+							generateBody(random, out, depth - 1);
+							out += " };\n";
+						}
+					}
+				}
+				out += generateExpression(random, 3);
+			}
+
+			// Functions in nested modules, with braces inside literals to mislead a brace matcher
+			std::string generateSource()
+			{
+				std::mt19937 random(5);
+				std::string source;
+				std::size_t openModules = 0;
+				for (std::size_t i = 0; i < FunctionCount; ++i) {
+					if (random() % 16 == 0 && openModules < 3) {
+						source += "module m" + std::to_string(i) + " {\n";
+						++openModules;
+					}
+					source += "fn f" + std::to_string(i) + "(a : int, b : float) -> int {\n";
+					generateBody(random, source, 2);
+					source += "\n}\n";
+					if (openModules > 0 && random() % 8 == 0) {
+						source += "}\n";
+						--openModules;
+					}
+				}
+				for (; openModules > 0; --openModules)
+					source += "}\n";
+				return source;
+			}
+
+			std::string printHIR(const AST::Root* root)
+			{
+				HIR::TranslationUnit tu;
+				HIR::ModuleBuilder builder(tu.getRootModule());
+				root->generateHIR(builder);
+				std::ostringstream out;
+				tu.print(out);
+				return out.str();
+			}
+
+			bool sameFlatTrees(const AST::FlatTree& expected, const AST::FlatTree& actual)
+			{
+				if (expected.size() != actual.size() || expected.getTopLevel() != actual.getTopLevel())
+					return false;
+				for (AST::NodeIndex i = 0; i < expected.size(); ++i) {
+					if (expected.getKind(i) != actual.getKind(i) || expected.getTag(i) != actual.getTag(i)
+						|| expected.getOffset(i) != actual.getOffset(i) || expected.getOperand(i) != actual.getOperand(i))
+						return false;
+				}
+				return true;
+			}
+
+			// Parses text serially and on each thread count, and compares the trees and the diagnostics
+			bool parsesAlike(const std::string& name, const std::string& text, bool valid)
+			{
+				SourceBuffer* source = SourceBuffer::fromString(text);
+				TokenStream* stream = TokenStream::lex(source);
+				Scanner scanner(stream);
+				std::ostringstream serialDiagnostics;
+				AST::Root* serial = AST::Root::parse(&scanner, serialDiagnostics);
+				AST::FlatTree* serialFlat = serial != nullptr ? AST::FlatTree::flatten(serial) : nullptr;
+				std::string serialHIR = serial != nullptr ? printHIR(serial) : std::string();
+
+				bool passed = (serial != nullptr) == valid;
+				if (!passed)
+					std::cout << name << ": parse " << (valid ? "failed: " + serialDiagnostics.str() : "succeeded") << std::endl;
+				const std::size_t threadCounts[] = { 1, 2, 3, 4, 8 };
+				for (std::size_t threadCount : threadCounts) {
+					std::ostringstream parallelDiagnostics;
+					AST::Root* parallel = AST::Root::parseParallel(stream, threadCount, parallelDiagnostics);
+					std::string context = name + ", " + std::to_string(threadCount) + " threads";
+					if ((parallel == nullptr) != (serial == nullptr)) {
+						std::cout << context << ": " << (parallel == nullptr ? "failed" : "succeeded") << " where parse did not" << std::endl;
+						passed = false;
+					}
+					else if (parallelDiagnostics.str() != serialDiagnostics.str()) {
+						std::cout << context << ": reported \"" << parallelDiagnostics.str() << "\", parse reported \"" << serialDiagnostics.str() << "\"" << std::endl;
+						passed = false;
+					}
+					else if (parallel != nullptr) {
+						AST::FlatTree* parallelFlat = AST::FlatTree::flatten(parallel);
+						if (!sameFlatTrees(*serialFlat, *parallelFlat) || printHIR(parallel) != serialHIR) {
+							std::cout << context << ": tree differs from parse" << std::endl;
+							passed = false;
+						}
+						delete parallelFlat;
+					}
+					delete parallel;
+				}
+
+				delete serialFlat;
+				delete serial;
+				delete stream;
+				delete source;
+				return passed;
+			}
+		}
+
+		// parseParallel has to build the same tree and report the same diagnostics as parse,
+		// whatever the thread count, including when the source does not parse.
+		bool parseParallelMatchesParse()
+		{
+			std::string source = generateSource();
+			std::size_t middle = source.find("fn f1500(");
+
+			std::string badStatement = source;
+			badStatement.insert(source.find('{', middle) + 1, " let = 3;");
+			std::string unclosedBody = source;
+			unclosedBody.erase(source.find("\n}\n", middle) + 1, 1);
+			std::string strayToken = source;
+			strayToken.insert(middle, "; ");
+			std::string badNumber = source;
+			badNumber.insert(source.find('{', middle) + 1, " 0x;");
+
+			bool passed = parsesAlike("valid", source, true);
+			passed = parsesAlike("bad statement", badStatement, false) && passed;
+			passed = parsesAlike("unclosed body", unclosedBody, false) && passed;
+			passed = parsesAlike("stray token", strayToken, false) && passed;
+			passed = parsesAlike("bad number", badNumber, false) && passed;
+			return passed;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include "Tests.hpp"
+#include "SourceBuffer.hpp"
+#include "SymbolTable.hpp"
+#include "TokenStream.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			const std::size_t CorpusSize = std::size_t(256) << 10;
+			const std::size_t EditCount = 400;
+		}
+
+		// A chain of edits, each relexed into the stream left by the one before, has to give
+		// exactly the tokens of lexing the edited file from scratch.
+		bool relexMatchesLex()
+		{
+			// Pieces that split, join or end tokens and open or close literals
+			static const char* const insertions[] = {
+				"", " ", "\n", "x", "name3", "9", "0x", ".5", "e+7", "b1", "=", ":", "+", "-", ".", "\"", "'", "\\",
+				"\"text\"", "fn f() { }", "12abc", "18446744073709551616", "\xC3",
+			};
+			const std::size_t insertionCount = sizeof(insertions) / sizeof(insertions[0]);
+
+			SymbolTable symbols;
+			SourceBuffer* source = SourceBuffer::fromString(generateTokenCorpus(CorpusSize));
+			TokenStream* stream = TokenStream::lex(source, &symbols);
+
+			std::mt19937 random(11);
+			bool passed = true;
+			for (std::size_t i = 0; i < EditCount && passed; ++i) {
+				SourceEdit edit;
+				edit.offset = random() % (source->getSize() + 1);
+				edit.removedLength = std::min<std::size_t>(random() % 6, source->getSize() - edit.offset);
+				edit.insertedText = insertions[random() % insertionCount];
+				SourceBuffer* edited = source->applyEdit(edit);
+
+				TokenDelta delta = stream->relex(edit, edited);
+				stream->applyDelta(delta);
+				TokenStream* fresh = TokenStream::lex(edited, &symbols);
+				std::string context = "edit " + std::to_string(i) + " at " + std::to_string(edit.offset)
+					+ " removing " + std::to_string(edit.removedLength) + " inserting '" + std::string(edit.insertedText) + "'";
+				passed = sameTokens(*fresh, *stream, context);
+
+				delete fresh;
+				delete source;
+				source = edited;
+			}
+
+			delete stream;
+			delete source;
+			return passed;
+		}
+	}
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Tests.hpp"
+#include "AST.hpp"
+#include "SourceBuffer.hpp"
+#include "SymbolTable.hpp"
+#include "TokenPipe.hpp"
+#include "TokenStream.hpp"
+
+namespace ozToy {
+	namespace Tests {
+
+		namespace {
+			const char* const Source =
+				"fn square(x : int) -> int { let y = x * x; y }\n"
+				"module geometry { fn area(width : int, height : int) -> int { let a = width * height; a } }\n";
+
+			// Hash of every top-level item parsed from scanner, none when parsing fails
+			std::vector<Hash128> hashItems(Scanner* scanner, AST::BodyParsing bodies)
+			{
+				std::vector<Hash128> hashes;
+				AST::Root* root = AST::Root::parse(scanner, std::cout, bodies);
+				if (root != nullptr) {
+					for (auto item : root->getTopLevel()) {
+						if (item->getKind() == AST::NodeKind::MODULE)
+							hashes.push_back(static_cast<const AST::Module*>(item)->getHash());
+						else
+							hashes.push_back(static_cast<const AST::DeclarationFunction*>(item)->getHash());
+					}
+					delete root;
+				}
+				return hashes;
+			}
+
+			std::vector<Hash128> hashItems(SourceBuffer* source, SymbolTable* symbols, AST::BodyParsing bodies)
+			{
+				TokenStream* stream = TokenStream::lex(source, symbols);
+				Scanner scanner(stream);
+				std::vector<Hash128> hashes = hashItems(&scanner, bodies);
+				delete stream;
+				return hashes;
+			}
+
+			// The resolveNames count and the names print lists, after lowering source lexed into symbols
+			std::string lowerAndResolve(SourceBuffer* source, SymbolTable* symbols, bool flat)
+			{
+				std::ostringstream out;
+				TokenStream* stream = TokenStream::lex(source, symbols);
+				Scanner scanner(stream);
+				AST::Root* root = AST::Root::parse(&scanner, std::cout);
+				if (root != nullptr) {
+					HIR::TranslationUnit tu(symbols);
+					HIR::ModuleBuilder builder(tu.getRootModule());
+					if (flat) {
+						AST::FlatTree* tree = AST::FlatTree::flatten(root, symbols);
+						tree->generateHIR(builder);
+						delete tree;
+					}
+					else {
+						root->generateHIR(builder);
+					}
+					out << tu.resolveNames(1) << " unresolved" << std::endl;
+					tu.print(out);
+					delete root;
+				}
+				delete stream;
+				return out.str();
+			}
+		}
+
+		// A stream lexed with a table of its own is parsed and hashed with that table, not the
+		// global one. The names in the private table get ids the global table uses for other
+		// names, or not at all, so looking them up in the wrong table changes the hashes.
+		bool streamUsesItsSymbolTable()
+		{
+			SourceBuffer* source = SourceBuffer::fromString(Source);
+			std::vector<Hash128> expected = hashItems(source, SymbolTable::getInstance(), AST::BodyParsing::EAGER);
+
+			SymbolTable symbols;
+			for (int i = 0; i < 1000; ++i)
+				symbols.intern("unrelated" + std::to_string(i));
+
+			bool passed = expected.size() == 2;
+			const AST::BodyParsing modes[] = { AST::BodyParsing::EAGER, AST::BodyParsing::LAZY };
+			for (AST::BodyParsing bodies : modes) {
+				if (hashItems(source, &symbols, bodies) != expected) {
+					std::cout << (bodies == AST::BodyParsing::EAGER ? "eager" : "lazy") << " parse with a private table hashes differently" << std::endl;
+					passed = false;
+				}
+			}
+			delete source;
+			return passed;
+		}
+
+		// Parsing from a TokenPipe hashes like parsing a stream. The producer is still interning
+		// while the parser runs, so the hashes are only taken once parsing has returned; build with
+		// -fsanitize=thread to check that nothing reads the table before that.
+		bool pipeHashesMatchStream()
+		{
+			std::string text;
+			for (int i = 0; i < 200; ++i)
+				text += "module m" + std::to_string(i) + " { fn f" + std::to_string(i) + "(a : int) -> int { let b" + std::to_string(i) + " = a * a; b" + std::to_string(i) + " } }\n";
+			SourceBuffer* source = SourceBuffer::fromString(text);
+			SymbolTable streamSymbols;
+			std::vector<Hash128> expected = hashItems(source, &streamSymbols, AST::BodyParsing::EAGER);
+
+			SymbolTable pipeSymbols;
+			std::vector<Hash128> hashes;
+			{
+				TokenPipe pipe(source, &pipeSymbols);
+				Scanner scanner(&pipe);
+				hashes = hashItems(&scanner, AST::BodyParsing::EAGER);
+			}
+			delete source;
+			if (expected.size() != 200 || hashes != expected) {
+				std::cout << "piped parse hashes differently" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		// Lowering and name resolution look names up in the unit's table, the one the source was
+		// lexed with. In the global table the private ids name other spellings, or none at all.
+		bool privateTableLowers()
+		{
+			SourceBuffer* source = SourceBuffer::fromString("fn f(zz : int) -> int { zz + yy[zz] }\n");
+			std::string expected = lowerAndResolve(source, SymbolTable::getInstance(), false);
+
+			SymbolTable symbols;
+			for (int i = 0; i < 1000; ++i)
+				symbols.intern("unrelated" + std::to_string(i));
+
+			bool passed = expected.find("yy") != std::string::npos && expected.find("zz") == std::string::npos;
+			for (bool flat : { false, true }) {
+				std::string unresolved = lowerAndResolve(source, &symbols, flat);
+				if (unresolved != expected) {
+					std::cout << (flat ? "flat" : "tree") << " lowering with a private table leaves" << std::endl << unresolved << "instead of" << std::endl << expected;
+					passed = false;
+				}
+			}
+			delete source;
+			return passed;
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+namespace ozToy {
+	class TokenStream;
+
+	namespace Tests {
+
+		// Shared by the token tests, in LexParallelTest.cpp
+		std::string generateTokenCorpus(std::size_t size);
+		// Prints the first token that differs, prefixed with context
+		bool sameTokens(const TokenStream& expected, const TokenStream& actual, const std::string& context);
+
+		// Every test prints what went wrong to std::cout and returns false on failure.
+		bool lexParallelMatchesLex();
+		bool longSequenceLowers();
+		bool lazyBodyFailureIsReported();
+		bool streamUsesItsSymbolTable();
+		bool pipeHashesMatchStream();
+		bool privateTableLowers();
+		bool nestedTypesResolve();
+		bool relexMatchesLex();
+		bool parseParallelMatchesParse();
+		bool numbersLexToValues();
+	}
+}
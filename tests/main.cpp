@@ -0,0 +1,33 @@
+#include <iostream>
+#include "Tests.hpp"
+
+// Runs every test and exits with the number that failed.
+// Built by tests.vcxproj, or from this directory with
+//   g++ -O2 -std=c++17 -fno-exceptions -fno-rtti -pthread -I../api -o tests *.cpp $(ls ../api/*.cpp | grep -v main.cpp)
+int main() {
+	struct Test {
+		const char* name;
+		bool (*run)();
+	};
+	const Test tests[] = {
+		{ "lexParallelMatchesLex", ozToy::Tests::lexParallelMatchesLex },
+		{ "longSequenceLowers", ozToy::Tests::longSequenceLowers },
+		{ "lazyBodyFailureIsReported", ozToy::Tests::lazyBodyFailureIsReported },
+		{ "streamUsesItsSymbolTable", ozToy::Tests::streamUsesItsSymbolTable },
+		{ "pipeHashesMatchStream", ozToy::Tests::pipeHashesMatchStream },
+		{ "privateTableLowers", ozToy::Tests::privateTableLowers },
+		{ "nestedTypesResolve", ozToy::Tests::nestedTypesResolve },
+		{ "relexMatchesLex", ozToy::Tests::relexMatchesLex },
+		{ "parseParallelMatchesParse", ozToy::Tests::parseParallelMatchesParse },
+		{ "numbersLexToValues", ozToy::Tests::numbersLexToValues },
+	};
+
+	int failures = 0;
+	for (const Test& test : tests) {
+		bool passed = test.run();
+		std::cout << (passed ? "[PASS] " : "[FAIL] ") << test.name << std::endl;
+		if (!passed)
+			++failures;
+	}
+	return failures;
+}